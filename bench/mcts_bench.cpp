@@ -0,0 +1,57 @@
+// Playouts per second of the parallel MCTS for 1, 2, 4, ... threads.
+//
+//   g++ -std=c++17 -O2 -pthread -Iinclude bench/mcts_bench.cpp
+//       src/MCTS.cpp src/Patterns.cpp src/PlayoutBoard.cpp src/SearchBoard.cpp
+//       src/GameLogic.cpp -o mcts_bench
+//   ./mcts_bench [boardSize] [milliseconds] [maxThreads]
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "MCTS.h"
+#include "SearchBoard.h"
+
+int main(int argc, char** argv)
+{
+    int size       = argc > 1 ? std::atoi(argv[1]) : 9;
+    int ms         = argc > 2 ? std::atoi(argv[2]) : 2000;
+    int maxThreads = argc > 3 ? std::atoi(argv[3])
+                              : (int)std::thread::hardware_concurrency();
+    if (!SearchBoard::isSupportedSize(size))
+        size = 9;
+    if (maxThreads < 1)
+        maxThreads = 1;
+
+    SearchBoard board(size);
+    std::vector<int> moves;
+    board.getLegalMoves(moves);
+
+    std::printf("board %dx%d, %d ms per search\n", size, size, ms);
+    std::printf("%8s %12s %14s %9s\n", "threads", "playouts", "playouts/s", "speedup");
+
+    double base = 0.0;
+    for (int threads = 1; ; threads *= 2)
+    {
+        if (threads > maxThreads)
+            threads = maxThreads;
+
+        MCTS::Options options;
+        options.timeLimitMs = ms;
+        options.threads     = threads;
+        MCTS mcts(options);
+        mcts.search(board, moves);
+
+        double rate = mcts.getPlayouts() * 1000.0 / ms;
+        if (threads == 1)
+            base = rate;
+        std::printf("%8d %12d %14.0f %8.2fx\n", threads, mcts.getPlayouts(), rate,
+                    base > 0.0 ? rate / base : 0.0);
+
+        if (threads == maxThreads)
+            break;
+    }
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+// Light and heavy playouts per second on one core, from the empty board.
+//
+//   g++ -std=c++17 -O2 -Iinclude bench/playout_bench.cpp
+//       src/PlayoutBoard.cpp src/Patterns.cpp src/SearchBoard.cpp src/GameLogic.cpp
+//       -o playout_bench
+//   ./playout_bench [boardSize] [milliseconds]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "PlayoutBoard.h"
+#include "SearchBoard.h"
+
+int main(int argc, char** argv)
+{
+    int size = argc > 1 ? std::atoi(argv[1]) : 9;
+    int ms   = argc > 2 ? std::atoi(argv[2]) : 2000;
+    if (!SearchBoard::isSupportedSize(size))
+        size = 9;
+
+    using Clock = std::chrono::steady_clock;
+
+    SearchBoard  start(size);
+    PlayoutBoard board;
+    std::mt19937 rng(12345);
+
+    std::printf("board %dx%d, %d ms per policy\n", size, size, ms);
+    std::printf("%8s %12s %14s %16s %10s\n", "policy", "playouts", "playouts/s", "stones at end", "black %");
+
+    const PlayoutBoard::Policy policies[] = { PlayoutBoard::Policy::Light, PlayoutBoard::Policy::Heavy };
+    for (PlayoutBoard::Policy policy : policies)
+    {
+        long long playouts = 0, moves = 0, blackWins = 0;
+        Clock::time_point begin = Clock::now();
+        Clock::time_point end   = begin + std::chrono::milliseconds(ms);
+        while (Clock::now() < end)
+        {
+            for (int i = 0; i < 64; ++i)
+            {
+                board.reset(start);
+                if (board.playout(rng, nullptr, policy) == SearchBoard::Black)
+                    ++blackWins;
+                moves += board.getBoardSize() * board.getBoardSize() - board.emptyCount();
+                ++playouts;
+            }
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+        std::printf("%8s %12lld %14.0f %16.1f %9.1f%%\n",
+                    policy == PlayoutBoard::Policy::Light ? "light" : "heavy",
+                    playouts, playouts / seconds,
+                    (double)moves / (double)playouts, 100.0 * blackWins / (double)playouts);
+    }
+    return 0;
+}
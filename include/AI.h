@@ -2,32 +2,153 @@
 #pragma once
 #include <utility>
 #include "GameLogic.h"   
+#include "SearchBoard.h"
+#include "MCTS.h"
+#include "TranspositionTable.h"
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
 enum class AIDifficulty {
     Easy = 1,
     Medium = 2,
-    Hard = 3
+    Hard = 3,
+    MCTS = 4     // Monte Carlo tree search, theo ngân sách playout / thời gian
 };
 
 class GoAI {
 public:
     GoAI(AIDifficulty diff = AIDifficulty::Easy);
+    ~GoAI();
 
     void setDifficulty(AIDifficulty diff);
     AIDifficulty getDifficulty() const;
 
-    
-    std::pair<int,int> chooseMove(const GoGame& game, int aiPlayerColor);
+    // Ngân sách cho mức MCTS (số playout và/hoặc thời gian) và kiểu playout
+    // (options.playoutPolicy: Light = ngẫu nhiên, Heavy = mặc định).
+    // Chỉ mức MCTS dùng playout.
+    void setMCTSOptions(const MCTS::Options& options);
+
+    // Số luồng cho MCTS và alpha-beta của Hard (0 = theo số nhân CPU).
+    // Hard dùng Lazy SMP: các luồng phụ cùng tìm từ gốc, chỉ chia sẻ
+    // bảng transposition.
+    void setThreads(int threads);
+
+    // Giới hạn mỗi nước: thời gian (ms, 0 = không giới hạn) và độ sâu tối đa.
+    // Medium / Hard đào sâu dần (iterative deepening) trong giới hạn này;
+    // với MCTS chỉ dùng timeMs.
+    // quiescenceNodes: số node tối đa cho quiescence search ở mỗi lá
+    // của Hard (0 = tắt).
+    struct SearchLimits {
+        int timeMs;
+        int maxDepth;
+        int quiescenceNodes = 64;
+    };
+    void setSearchLimits(AIDifficulty diff, const SearchLimits& limits);
+    SearchLimits getSearchLimits(AIDifficulty diff) const;
+
+    // Dung lượng bảng transposition cho mức Hard (MB)
+    void setHashSizeMB(std::size_t megabytes);
+
+    // Pondering (Hard, MCTS): sau khi AI đi, tiếp tục tìm trên luồng nền
+    // trong lượt người chơi. startPondering nhận ván sau nước của AI;
+    // chooseMove tự dừng pondering và dùng lại kết quả.
+    void setPondering(bool enabled);
+    bool isPonderingEnabled() const { return m_ponderEnabled; }
+    void startPondering(const GoGame& game, int aiColor);
+    void stopPondering();
+
+    // Số node minimax / alpha-beta đã duyệt trong lần chooseMove gần nhất
+    // (cộng cả các luồng)
+    long long getNodeCount() const { return m_nodes; }
+
+    // stop (tùy chọn): đặt true từ luồng khác để dừng tìm kiếm sớm;
+    // khi đó nước trả về không còn ý nghĩa.
+    std::pair<int,int> chooseMove(const GoGame& game, int aiPlayerColor,
+                                  const std::atomic<bool>* stop = nullptr);
 
 private:
     AIDifficulty m_diff;
+    MCTS         m_mcts;
+
+    // Bảng transposition của alpha-beta (giá trị theo màu của AI),
+    // dùng chung cho mọi luồng
+    TranspositionTable m_tt;
+
+    using Clock = std::chrono::steady_clock;
+
+    SearchLimits      m_mediumLimits = {500, 2};
+    SearchLimits      m_hardLimits   = {1000, 32};
+    Clock::time_point m_deadline;
+    bool              m_hasDeadline = false;
+    long long         m_nodes       = 0;
+
+    // Lazy SMP cho Hard
+    int               m_threads = 0;          // 0 = theo số nhân CPU
+    std::atomic<bool> m_helpersStop{false};   // luồng chính xong thì dừng luồng phụ
+
+    bool              m_ponderEnabled = false;
+    std::thread       m_ponderThread;
+    std::atomic<bool> m_ponderStop{false};
+
+    static constexpr int kMaxPly = 64;
+
+    // Trạng thái riêng của mỗi luồng tìm kiếm
+    struct SearchContext {
+        // Sắp xếp nước: 2 killer mỗi ply, history theo màu + điểm
+        std::array<std::array<int, 2>, kMaxPly>                 killers{};
+        std::array<std::array<int, SearchBoard::kMaxPoints>, 2> history{};
+
+        const std::atomic<bool>* stop    = nullptr;   // cờ hủy của người gọi
+        long long                nodes   = 0;
+        bool                     timeUp  = false;
+        int                      qBudget = 0;         // node quiescence còn lại ở lá
+    };
+    SearchContext              m_main;
+    std::vector<SearchContext> m_helpers;
+
+    struct Candidate {
+        int p;
+        double eval;
+    };
+
+    // Nước tốt nhất của vòng đào sâu sâu nhất đã xong (mọi luồng)
+    struct RootResult {
+        std::mutex lock;
+        int depth = 0;
+        int move  = -1;
+    };
+
+    int  hardThreads() const;
+    void searchRoot(SearchContext& ctx, SearchBoard root, std::vector<Candidate> candidates,
+                    int aiColor, int firstDepth, bool isMain,
+                    Clock::time_point start, RootResult& result);
+
+    void orderMoves(const SearchContext& ctx, const SearchBoard& state,
+                    std::vector<int>& moves, int ttMove, int ply) const;
+    void recordCutoff(SearchContext& ctx, const SearchBoard& state, int p, int depth, int ply);
+    void resetMoveOrdering(SearchContext& ctx);
+
+    bool outOfTime(SearchContext& ctx);
+    void ponder(GoGame game, int aiColor);
 
    
-    double evaluatePosition(const GoGame& game, int aiColor) const;
+    double evaluatePosition(const SearchBoard& board, int aiColor) const;
+
+    double minimax(SearchContext& ctx, SearchBoard& state, int depth,
+                   bool maximizingPlayer, int aiColor);
+
+    double minimaxAlphaBeta(SearchContext& ctx, SearchBoard& state, int depth,
+                            bool maximizingPlayer, int aiColor,
+                            double alpha, double beta, int ply);
 
-    double minimax(GoGame state, int depth, bool maximizingPlayer,
-                   int aiColor);
+    // Ở lá của alpha-beta: chỉ đi tiếp nước ăn quân và thoát atari
+    static constexpr int kMaxQuiescenceDepth = 8;
 
-    double minimaxAlphaBeta(GoGame state, int depth, bool maximizingPlayer,
-                            int aiColor, double alpha, double beta);
+    double quiescence(SearchContext& ctx, SearchBoard& state, bool maximizingPlayer,
+                      int aiColor, double alpha, double beta, int qDepth);
+    void tacticalMoves(const SearchBoard& state, std::vector<int>& moves) const;
 };
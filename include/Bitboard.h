@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstdint>
+
+// Fixed-size bit set over the padded board grid of SearchBoard (up to
+// 21 x 21 points, bit index = point index). All operations work a whole
+// 64-bit word at a time over a constant number of words, so the loops are
+// branch-free and the compiler can vectorize them.
+//
+// The whole-set operations take an optional word count W: a smaller board
+// only uses the first (stride * stride + 63) / 64 words, and the rest are
+// left zero.
+//
+// Because the grid has a Wall border, shifting by 1 or by the stride never
+// carries a bit from one row into the next row's playable points, as long
+// as the result is masked with a set of on-board points.
+class Bitboard
+{
+public:
+    static constexpr int kBits  = 21 * 21;
+    static constexpr int kWords = (kBits + 63) / 64;
+
+    Bitboard() : m_words{} {}
+
+    void set(int p)        { m_words[p >> 6] |=  (std::uint64_t{1} << (p & 63)); }
+    void reset(int p)      { m_words[p >> 6] &= ~(std::uint64_t{1} << (p & 63)); }
+    bool test(int p) const { return (m_words[p >> 6] >> (p & 63)) & 1u; }
+
+    bool any() const
+    {
+        std::uint64_t acc = 0;
+        for (int i = 0; i < kWords; ++i)
+            acc |= m_words[i];
+        return acc != 0;
+    }
+
+    template <int W = kWords>
+    int count() const
+    {
+        int n = 0;
+        for (int i = 0; i < W; ++i)
+            n += popcount(m_words[i]);
+        return n;
+    }
+
+    // Calls f(p) for every set point, in increasing order.
+    template <class F>
+    void forEach(F f) const
+    {
+        for (int i = 0; i < kWords; ++i)
+        {
+            std::uint64_t w = m_words[i];
+            while (w)
+            {
+                f(i * 64 + lowestBit(w));
+                w &= w - 1;
+            }
+        }
+    }
+
+    // Bits moved towards higher / lower point indices (0 < n < 64).
+    template <int W = kWords>
+    Bitboard shiftedUp(int n) const
+    {
+        Bitboard r;
+        r.m_words[0] = m_words[0] << n;
+        for (int i = 1; i < W; ++i)
+            r.m_words[i] = (m_words[i] << n) | (m_words[i - 1] >> (64 - n));
+        return r;
+    }
+
+    template <int W = kWords>
+    Bitboard shiftedDown(int n) const
+    {
+        Bitboard r;
+        for (int i = 0; i < W - 1; ++i)
+            r.m_words[i] = (m_words[i] >> n) | (m_words[i + 1] << (64 - n));
+        r.m_words[W - 1] = m_words[W - 1] >> n;
+        return r;
+    }
+
+    // The set plus its four neighbors on a grid with the given stride.
+    template <int W = kWords>
+    Bitboard dilated(int stride) const
+    {
+        Bitboard r = *this;
+        Bitboard a = shiftedUp<W>(1);
+        Bitboard b = shiftedDown<W>(1);
+        Bitboard c = shiftedUp<W>(stride);
+        Bitboard d = shiftedDown<W>(stride);
+        for (int i = 0; i < W; ++i)
+            r.m_words[i] |= a.m_words[i] | b.m_words[i] | c.m_words[i] | d.m_words[i];
+        return r;
+    }
+
+    // Grows seed through mask (one step of dilation at a time) until it
+    // stops changing. The result is every point of mask connected to seed.
+    template <int W = kWords>
+    static Bitboard fill(Bitboard seed, const Bitboard& mask, int stride)
+    {
+        for (int i = 0; i < W; ++i)
+            seed.m_words[i] &= mask.m_words[i];
+
+        for (;;)
+        {
+            Bitboard next = seed.dilated<W>(stride);
+
+            std::uint64_t changed = 0;
+            for (int i = 0; i < W; ++i)
+            {
+                next.m_words[i] &= mask.m_words[i];
+                changed |= next.m_words[i] ^ seed.m_words[i];
+            }
+            if (!changed)
+                return seed;
+            seed = next;
+        }
+    }
+
+    Bitboard& operator|=(const Bitboard& o)
+    {
+        for (int i = 0; i < kWords; ++i)
+            m_words[i] |= o.m_words[i];
+        return *this;
+    }
+
+    Bitboard& operator&=(const Bitboard& o)
+    {
+        for (int i = 0; i < kWords; ++i)
+            m_words[i] &= o.m_words[i];
+        return *this;
+    }
+
+    friend Bitboard operator|(Bitboard a, const Bitboard& b) { return a |= b; }
+    friend Bitboard operator&(Bitboard a, const Bitboard& b) { return a &= b; }
+
+    // a & ~b
+    friend Bitboard andNot(Bitboard a, const Bitboard& b)
+    {
+        for (int i = 0; i < kWords; ++i)
+            a.m_words[i] &= ~b.m_words[i];
+        return a;
+    }
+
+    friend bool operator==(const Bitboard& a, const Bitboard& b)
+    {
+        std::uint64_t diff = 0;
+        for (int i = 0; i < kWords; ++i)
+            diff |= a.m_words[i] ^ b.m_words[i];
+        return diff == 0;
+    }
+
+    friend bool operator!=(const Bitboard& a, const Bitboard& b) { return !(a == b); }
+
+private:
+    std::uint64_t m_words[kWords];
+
+    static int popcount(std::uint64_t x)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(x);
+#else
+        int n = 0;
+        while (x)
+        {
+            x &= x - 1;
+            ++n;
+        }
+        return n;
+#endif
+    }
+
+    static int lowestBit(std::uint64_t x)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(x);
+#else
+        int n = 0;
+        while (!(x & 1u))
+        {
+            x >>= 1;
+            ++n;
+        }
+        return n;
+#endif
+    }
+};
@@ -4,8 +4,10 @@
 #include <vector>
 #include <string>
 #include <utility> 
+#include <cstdint>
+#include <unordered_set>
 
-
+#include "SearchBoard.h"
 
 class GoGame
 {
@@ -26,18 +28,7 @@ public:
     };
 
    
-    struct JapaneseScore
-    {
-        int    blackTerritory = 0;
-        int    whiteTerritory = 0;
-        int    neutral        = 0;    
-        int    blackCaptures  = 0;
-        int    whiteCaptures  = 0;
-        double komi           = 0.0;  
-        double blackTotal = 0;
-        double whiteTotal = 0;
-        
-    };
+    using JapaneseScore = SearchBoard::Score;
 
     struct MarkDeadResult
     {   
@@ -56,8 +47,8 @@ public:
     
     
         
-    void   setKomi(double k) { m_komi = k; }
-    double getKomi() const   { return m_komi; }
+    void   setKomi(double k) { m_board.setKomi(k); }
+    double getKomi() const   { return m_board.getKomi(); }
 
     
     JapaneseScore computeJapaneseScore() const;
@@ -76,24 +67,29 @@ public:
     void reset(int boardSize);
 
 
-    int getBoardSize() const { return m_boardSize; }
-    int getCurrentPlayer() const { return m_currentPlayer; } 
+    int getBoardSize() const { return m_board.getBoardSize(); }
+    int getCurrentPlayer() const { return m_board.getCurrentPlayer(); } 
     void setCurrentPlayer(int p)   
         {
-            if (p == 0 || p == 1)
-                m_currentPlayer = p;
+            m_board.setCurrentPlayer(p);
         }
 
   
     int getCell(int row, int col) const;
 
-    int getBlackCaptured() const { return m_blackCaptured; }
-    int getWhiteCaptured() const { return m_whiteCaptured; }
+    int getBlackCaptured() const { return m_board.getBlackCaptured(); }
+    int getWhiteCaptured() const { return m_board.getWhiteCaptured(); }
+
+    // Stones, chains and liberties of the current position.
+    const SearchBoard& getBoard() const { return m_board; }
     bool isGameOver() const { return m_gameOver; }
     bool isMarkingDead() const { return m_phase == Phase::MarkDead; }
     bool isPlaying()    const { return m_phase == Phase::Playing; }
 
-  
+    // Same checks and effect as playMove, without building a message.
+    MoveStatus tryMove(int row, int col, int* captured = nullptr);
+    static const char* moveStatusMessage(MoveStatus status);
+
     MoveResult playMove(int row, int col);
 
     
@@ -107,6 +103,25 @@ public:
    
     
     std::vector<std::pair<int,int>> getLegalMoves() const;
+
+    // Point the side to move may not play because of ko, if any.
+    bool getKoPoint(int& row, int& col) const;
+
+    // Positional superko: a move may not recreate any earlier position.
+    // Off by default (simple ko only).
+    void setSuperko(bool on);
+    bool isSuperko() const   { return m_superko; }
+
+    // True when the legal move at (row, col) repeats an earlier position.
+    bool repeatsPosition(int row, int col) const;
+
+    // Replaces the position with a search board's (history restarts here).
+    void loadPosition(const SearchBoard& board);
+
+    // Make/unmake on the current position, for search. (-1, -1) is a pass.
+    // Not recorded in the undo/redo history; undo in reverse order.
+    bool doMove(int row, int col, SearchBoard::Undo& u);
+    void undoMove(const SearchBoard::Undo& u);
    
     MarkDeadResult markDeadGroup(int row, int col);
 
@@ -117,62 +132,75 @@ public:
     bool undo();
     bool redo();
 private:
-    int m_boardSize;       
-    int m_currentPlayer;  
-    int m_blackCaptured;
-    int m_whiteCaptured;
-    
-
-    double m_komi = 6.5;
     bool m_gameOver;
     int m_consecutivePasses; 
 
   
-    std::vector<int> m_boardCells;
-
-    
-    std::vector<int> m_prevBoardCells;
-    bool             m_hasPrevBoard;
+    // Stones, chains, side to move, ko point, captures and komi.
+    SearchBoard m_board;
 
     Phase             m_phase = Phase::Playing;
     std::vector<bool> m_deadMarks;   
 
+    bool m_superko = false;
+
+    // Position hashes of history entries 0..m_historyIndex.
+    std::unordered_set<std::uint64_t> m_seenPositions;
+
  
-    void ensureBoardArray(); 
+    std::vector<int> deadStonePoints() const;
+
+    // Undo/redo history is a log of small records, one per step, that are
+    // replayed on top of the nearest keyframe. A keyframe (packed stones and
+    // counters) is kept every kKeyframeInterval entries.
+    enum class StepType : std::uint8_t {
+        Start,          // entry 0 of a fresh history
+        Move,
+        Pass,
+        RemoveGroup,    // markDeadGroup
+        Finalize        // finalizeScore
+    };
 
-    
-    void getGroupAndLiberties(
-        int row, int col, int color,
-        std::vector<int>& outGroup,
-        int& outLiberties,
-        const std::vector<int>& board
-    ) const;
-    JapaneseScore computeJapaneseScoreImpl(
-        const std::vector<int>& board,
-        int extraBlackCap,
-        int extraWhiteCap
-    ) const;
-
-    struct GameState {
+    static constexpr std::uint32_t kNoPayload        = 0xFFFFFFFFu;
+    static constexpr int           kKeyframeInterval = 64;
+
+    struct HistoryStep {
+        StepType      type;
+        std::uint16_t point;
+        // Offset in m_historyPayload of [removed count, removed points...,
+        // dead-mark count, marked indices...], or kNoPayload.
+        std::uint32_t payload;
+    };
+
+    struct Keyframe {
+        int index;
         int boardSize;
         int currentPlayer;
+        int koPoint;
         int blackCaptured;
         int whiteCaptured;
         bool gameOver;
         int consecutivePasses;
         Phase phase;
-        bool hasPrevBoard;
-        std::vector<int> boardCells;
-        std::vector<int> prevBoardCells;
-        std::vector<bool> deadMarks;
+        std::vector<signed char>   cells;
+        std::vector<std::uint16_t> deadMarks;
     };
 
-    std::vector<GameState> m_history;
+    std::vector<HistoryStep>   m_history;
+    std::vector<std::uint16_t> m_historyPayload;
+    std::vector<Keyframe>      m_keyframes;
     int m_historyIndex = -1;
 
-    
-
-    void saveState();           
+    void clearHistory();
+    void saveState(StepType type, int point = 0,
+                   const std::vector<int>* removed = nullptr);
     void restoreState(int idx); 
+
+    void applyMove(int p, int* captured);
+    void applyPass();
+    void applyFinalize(const std::vector<int>& dead);
+    void loadKeyframe(const Keyframe& kf);
+    void replayStep(const HistoryStep& step);
+    void rebuildSeenPositions();
 };
 
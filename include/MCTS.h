@@ -0,0 +1,157 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "PlayoutBoard.h"
+#include "SearchBoard.h"
+
+// UCT Monte Carlo tree search with random playouts, run by several threads
+// on one shared tree.
+//
+// The tree is a preallocated pool of nodes; the children of a node are
+// stored next to each other and are all created the first time the node is
+// expanded. Visit and win counters are atomics. A thread counts its visit
+// on the way down, before the playout result is known (virtual loss), so
+// other threads are steered to different branches. Expansion is claimed
+// with a compare-and-swap on the node state and its children are reserved
+// with a fetch-add on the pool; a thread that finds a node being expanded
+// just runs its playout from there instead of waiting.
+//
+// Every node also keeps all-moves-as-first (AMAF) counts: a playout that
+// passes through a node credits each child whose move the same color played
+// anywhere later in that playout. Selection blends the child's own win rate
+// with its AMAF rate (RAVE), trusting AMAF while the child has few visits
+// of its own, so a move looks good or bad after a handful of playouts
+// instead of a few hundred. Moves that make a known 3x3 shape start with
+// some AMAF wins already counted.
+//
+// The tree is kept after a search. When the next search starts from a
+// position one or two moves below the old root (the opponent's reply, or
+// our move plus the reply), that subtree becomes the new root and its
+// statistics are kept; everything else is dropped. ponder() grows the tree
+// on the opponent's time so the next search starts with more of it.
+//
+// The tree is walked on a SearchBoard; playouts then run on a PlayoutBoard
+// copy of the position (same rules, a fraction of the cost per move) and
+// are scored with the Japanese count GoGame uses. By default playouts are
+// heavy: they answer the last move with captures, atari escapes and known
+// shapes before falling back to random moves.
+class MCTS
+{
+public:
+    struct Options
+    {
+        int    maxPlayouts = 0;         // 0 = no playout limit
+        int    timeLimitMs = 1000;      // 0 = no time limit
+        double exploration = 0.1;       // UCT exploration constant (about 1.0 without RAVE)
+        int    threads     = 0;         // 0 = one per hardware thread
+        int    maxNodes    = 1 << 20;   // the tree stops growing when full
+
+        // Visits at which a child's own win rate and its AMAF rate get
+        // equal weight; 0 = plain UCT.
+        double raveEquivalence = 1000.0;
+
+        // AMAF playouts credited up front to moves that make a known 3x3
+        // shape (Patterns); 0 = none.
+        int shapePrior = 50;
+
+        // How playouts pick their moves (see PlayoutBoard::Policy).
+        PlayoutBoard::Policy playoutPolicy = PlayoutBoard::Policy::Heavy;
+    };
+
+    MCTS();
+    explicit MCTS(const Options& options);
+
+    void setOptions(const Options& options) { m_options = options; }
+    const Options& getOptions() const      { return m_options; }
+
+    // Best point among rootMoves (legal moves of the side to move in root),
+    // or -1 to pass when none of them is worth playing. The search also ends
+    // early once *stop becomes true.
+    int search(const SearchBoard& root, const std::vector<int>& rootMoves,
+               const std::atomic<bool>* stop = nullptr);
+
+    // Searches root (the opponent to move) without time or playout limits
+    // until *stop becomes true, keeping the tree for the next search.
+    void ponder(const SearchBoard& root, const std::vector<int>& rootMoves,
+                const std::atomic<bool>* stop);
+
+    // Drops the kept tree.
+    void clearTree() { m_hasTree = false; }
+
+    // Statistics of the last search.
+    int getPlayouts() const     { return m_playouts.load(); }
+    int getThreads() const      { return m_threadsUsed; }
+    int getReusedVisits() const { return m_reusedVisits; }   // root visits taken over
+
+private:
+    enum NodeState
+    {
+        Leaf,
+        Expanding,
+        Expanded
+    };
+
+    struct Node
+    {
+        int              move;         // point played to reach this node (-1 at the root)
+        int              color;        // color that played it
+        int              parent;
+        int              firstChild;   // valid once state is Expanded
+        int              childCount;
+        std::atomic<int> state;
+        std::atomic<int> visits;       // includes playouts still running
+        std::atomic<int> wins;         // playouts won by `color`
+        std::atomic<int> amafVisits;   // playouts below the parent where `color` played `move`
+        std::atomic<int> amafWins;
+    };
+
+    // Per-thread scratch space.
+    struct Worker
+    {
+        std::vector<int>                 moves;
+        PlayoutBoard                     playoutBoard;
+        std::vector<std::pair<int, int>> played;       // playout moves (point, color)
+        std::vector<int>                 firstColor;   // per point, for AMAF
+        std::mt19937                     rng;
+    };
+
+    Options                 m_options;
+    std::unique_ptr<Node[]> m_nodes;
+    int                     m_capacity = 0;
+    std::atomic<int>        m_nodeCount{0};
+
+    std::atomic<int>         m_started{0};
+    std::atomic<int>         m_playouts{0};
+    std::atomic<bool>        m_stop{false};
+    const std::atomic<bool>* m_external    = nullptr;   // caller's stop flag
+    int                      m_threadsUsed = 0;
+    unsigned                 m_seed        = 0x4D435453u;
+
+    std::vector<Worker> m_workers;
+
+    // Position at the root of the kept tree.
+    SearchBoard m_treeBoard;
+    bool        m_hasTree      = false;
+    int         m_maxPlayouts  = 0;
+    int         m_reusedVisits = 0;
+
+    int  run(const SearchBoard& root, const std::vector<int>& rootMoves,
+             const std::atomic<bool>* stop, bool limited);
+    int  findReusable(const SearchBoard& root) const;
+    void promote(int from, const SearchBoard& root, const std::vector<int>& rootMoves);
+
+    void initNode(int index, int move, int color, int parent);
+    void setPrior(int index, const SearchBoard& board);
+    void expand(int node, const SearchBoard& board, Worker& w);
+    int  select(int node) const;
+    void runWorker(Worker& w, const SearchBoard& root, long long deadlineNs);
+    int  playout(const SearchBoard& board, int lastMove, Worker& w) const;
+    void backpropagate(int node, int winner, Worker& w);
+
+    static bool isOwnEye(const SearchBoard& board, int p, int color);
+};
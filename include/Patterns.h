@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+#include "SearchBoard.h"
+
+// 3x3 shape knowledge, looked up with SearchBoard::patternKey().
+//
+// A table with one entry per 20-bit key gives the weight of playing the
+// center point. It is built once from a short list of classic shapes (the
+// hane, cut and edge patterns MoGo uses in its playouts), each entered in
+// all 8 rotations and reflections and with the colors swapped, so a lookup
+// is a single load whoever is to move.
+namespace Patterns
+{
+    // 0 when the neighborhood matches no known shape, otherwise 1..100
+    // (more urgent is higher). Only meaningful for an empty point.
+    int weight(std::uint32_t key);
+
+    inline int weight(const SearchBoard& board, int p)
+    {
+        return weight(board.patternKey(p));
+    }
+}
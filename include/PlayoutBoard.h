@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "SearchBoard.h"
+
+// Minimal board for random playouts: the cells, chains with pseudo-liberty
+// counts, a list of the empty points and the ko point. No hashing, no
+// territory upkeep and no undo, so a move costs a few dozen instructions.
+// Points are numbered like SearchBoard's, so moves can go back and forth
+// between the two.
+//
+// A pseudo-liberty is an (empty point, adjacent stone) pair. A chain's count
+// can overstate its liberties, but it is zero exactly when the chain has
+// none, which is all that capture and suicide detection need.
+//
+// The empty points are kept in an array with each point's index next to
+// it, so a random empty point is one load and a point joins or leaves the
+// list in O(1). Each point also counts its empty, black and white
+// neighbors, which settles most legality and eye checks with one load.
+//
+// Each chain also keeps the sum and the sum of squares of its
+// pseudo-liberty points. All the pseudo-liberties are the same point
+// exactly when libs * sumSq == sum * sum, so an exact atari test (and the
+// point that captures) is O(1) too. The heavy playout policy relies on it.
+class PlayoutBoard
+{
+public:
+    // Light: uniformly random moves. Heavy: first capture a chain next to
+    // the last move that is in atari, then save an own chain next to it
+    // that is in atari, then play a known 3x3 shape (Patterns) around it,
+    // and only then a random move.
+    enum class Policy
+    {
+        Light,
+        Heavy
+    };
+
+    PlayoutBoard() = default;
+    explicit PlayoutBoard(const SearchBoard& board) { reset(board); }
+
+    // Copies the stones, side to move, ko point, capture counts and komi.
+    // lastMove is what the heavy policy answers first (-1 = none).
+    void reset(const SearchBoard& board, int lastMove = -1);
+
+    int getBoardSize() const    { return m_size; }
+    int getCurrentColor() const { return m_toMove; }   // Black or White
+    int at(int p) const         { return m_cells[(std::size_t)p]; }
+    int emptyCount() const      { return m_emptyCount; }
+    int lastMove() const        { return m_lastMove; }
+
+    // For a stone: the only liberty of its chain, or -1 when the chain has
+    // two or more. O(1).
+    int atariPoint(int p) const;
+
+    // Same 20-bit key as SearchBoard::patternKey(), for Patterns::weight().
+    std::uint32_t patternKey(int p) const;
+
+    // Empty, not the ko point and not suicide, for the side to move.
+    bool isLegal(int p) const;
+
+    // Empty point surrounded by color with at most one opponent diagonal
+    // (none on the edge): the same rule MCTS uses to never fill an eye.
+    bool isOwnEye(int p, int color) const;
+
+    // p must be legal for the side to move.
+    void play(int p);
+    void pass();
+
+    // Legal moves that do not fill an own eye, chosen by policy, until both
+    // sides pass (or 3 * size * size moves), then the winner by
+    // computeScore(). Each move is appended to played as (point, color)
+    // when given.
+    int playout(std::mt19937& rng, std::vector<std::pair<int, int>>* played = nullptr,
+                Policy policy = Policy::Light);
+
+    // Same count as SearchBoard::computeScore: territory + captures + komi.
+    SearchBoard::Score computeScore() const;
+
+private:
+    using Points = std::array<short, SearchBoard::kMaxPoints>;
+
+    int    m_size   = 9;
+    int    m_stride = 11;
+    int    m_offsets[4] = {};
+    int    m_around[8]  = {};   // SearchBoard::patternAt() order
+    int    m_toMove  = SearchBoard::Black;
+    int    m_koPoint = -1;
+    int    m_lastMove = -1;
+    int    m_blackCaptured = 0;
+    int    m_whiteCaptured = 0;
+    double m_komi = 0.0;
+
+    std::array<signed char, SearchBoard::kMaxPoints> m_cells{};
+    Points m_chainHead{};
+    Points m_chainNext{};
+    Points m_chainSize{};    // valid at the head
+    Points m_chainLibs{};    // pseudo-liberties, valid at the head
+    std::array<int, SearchBoard::kMaxPoints> m_chainLibSum{};     // of their points
+    std::array<int, SearchBoard::kMaxPoints> m_chainLibSumSq{};   // of their squares
+
+    // Neighbor counts, 4 bits per Cell value (Empty, Black, White).
+    std::array<std::uint16_t, SearchBoard::kMaxPoints> m_counts{};
+
+    Points m_empty{};        // the empty points, in no particular order
+    Points m_emptyIndex{};   // where each empty point sits in m_empty
+    int    m_emptyCount = 0;
+
+    void setStone(int p, int color);
+    void clearStone(int p, int color);
+    static int countOf(std::uint16_t counts, int cell) { return (counts >> (4 * cell)) & 15; }
+
+    void addEmpty(int p);
+    void removeEmpty(int p);
+    void swapEmpty(int i, int j);
+
+    void addLiberty(int head, int p)
+    {
+        ++m_chainLibs[(std::size_t)head];
+        m_chainLibSum[(std::size_t)head]   += p;
+        m_chainLibSumSq[(std::size_t)head] += p * p;
+    }
+    void removeLiberty(int head, int p)
+    {
+        --m_chainLibs[(std::size_t)head];
+        m_chainLibSum[(std::size_t)head]   -= p;
+        m_chainLibSumSq[(std::size_t)head] -= p * p;
+    }
+
+    void mergeChains(int a, int b);
+    int  captureChain(int head);
+
+    // The heavy policy's move for the side to move, or -1 to play randomly.
+    int  policyMove(std::uint64_t& state);
+    bool isGoodMove(int p) const;
+};
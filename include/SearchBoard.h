@@ -0,0 +1,258 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "Bitboard.h"
+
+class GoGame;
+
+// Outcome of trying to play a point. Cheap to return and compare; the
+// UI turns it into text only when it has to show it.
+enum class MoveStatus : std::uint8_t
+{
+    Ok,
+    NotPlaying,     // scoring phase
+    GameOver,
+    OutOfBoard,
+    Occupied,
+    Ko,
+    Suicide,
+    Superko
+};
+
+// Compact Go position used by the AI search and as the core of GoGame.
+// Holds only the cells, side to move, ko point and capture counts, so a copy
+// is a flat memcpy with no heap allocation. History, dead marks and the
+// UI messages stay in GoGame.
+//
+// Points are indices into a padded (size + 2) x (size + 2) grid whose border
+// is filled with Wall, so neighbors never need bounds checks.
+//
+// Chains (strings) are tracked incrementally: every stone knows its chain
+// head, the stones of a chain form a circular linked list, and the head
+// stores the chain size and its exact liberty count.
+//
+// A 64-bit Zobrist hash of the stones is kept up to date by every
+// placement and capture, and so are one bitboard per color.
+//
+// Territory is kept up to date too, as the set of empty points each color
+// reaches through empty points. A placement usually changes it in O(1);
+// otherwise only the empty regions next to the changed points are
+// re-flooded. computeScore() just counts bits.
+//
+// Every point also keeps a 16-bit code of its 3x3 neighborhood, two bits
+// (a Cell value) per neighbor. Placing or removing a stone only rewrites
+// the codes of its eight neighbors.
+//
+// The whole-board kernels (legal moves, chain rebuild, territory) are
+// templates over the board size; the public functions switch on the size
+// once and call the 9x9, 13x13 or 19x19 instance.
+class SearchBoard
+{
+public:
+    enum Cell
+    {
+        Empty = 0,
+        Black = 1,
+        White = 2,
+        Wall  = 3
+    };
+
+    static constexpr int kMaxSize   = 19;
+    static constexpr int kMaxStride = kMaxSize + 2;
+    static constexpr int kMaxPoints = kMaxStride * kMaxStride;
+    static_assert(kMaxPoints <= Bitboard::kBits, "Bitboard too small for the board");
+
+    struct Score
+    {
+        int    blackTerritory = 0;
+        int    whiteTerritory = 0;
+        int    neutral        = 0;
+        int    blackCaptures  = 0;
+        int    whiteCaptures  = 0;
+        double komi           = 0.0;
+        double blackTotal     = 0;
+        double whiteTotal     = 0;
+    };
+
+    // Everything doMove changes, so undoMove can put it back exactly.
+    // Plain data; lives on the caller's stack.
+    struct Undo
+    {
+        int           point;            // -1 for a pass
+        int           koPoint;
+        int           toMove;
+        int           blackCaptured;
+        int           whiteCaptured;
+        std::uint64_t hash;
+
+        // Stale chain entries of the empty point that was played.
+        short pointHead, pointNext, pointSize, pointLibs;
+
+        // Neighboring chains before the move.
+        int   chainCount;
+        short chainHead[4];
+        short chainSize[4];
+        short chainLibs[4];
+
+        // Merges in the order they happened (winner, absorbed head).
+        int   mergeCount;
+        short mergeA[4];
+        short mergeB[4];
+
+        // Heads of the captured chains.
+        int   captureCount;
+        short captureHead[4];
+
+        // Territory sets before the move.
+        Bitboard reach[2];
+    };
+
+public:
+    explicit SearchBoard(int boardSize = 9);
+
+    static bool isSupportedSize(int n) { return n == 9 || n == 13 || n == 19; }
+
+    static SearchBoard fromGame(const GoGame& game);
+    GoGame toGame() const;
+
+    // Replaces the stones (row-major, size * size) and rebuilds the chains.
+    void setPosition(const std::vector<int>& cells, int currentPlayer,
+                     int blackCaptured, int whiteCaptured, int koPoint = -1);
+
+    int getBoardSize() const { return m_size; }
+    int getStride() const    { return m_stride; }
+
+    // 0 = Black, 1 = White (same convention as GoGame)
+    int  getCurrentPlayer() const { return m_toMove; }
+    int  getCurrentColor() const  { return m_toMove == 0 ? Black : White; }
+    void setCurrentPlayer(int p);
+
+    int getBlackCaptured() const { return m_blackCaptured; }
+    int getWhiteCaptured() const { return m_whiteCaptured; }
+    double getKomi() const       { return m_komi; }
+    void   setKomi(double k)     { m_komi = k; }
+
+    int getKoPoint() const { return m_koPoint; }
+
+    // Zobrist hash of the stones only (positional superko).
+    std::uint64_t positionHash() const { return m_hash; }
+
+    // Stones plus side to move and ko point (search table keys).
+    std::uint64_t getHash() const;
+
+    // positionHash() after the legal move p, without playing it.
+    std::uint64_t positionHashAfter(int p) const;
+
+    int point(int row, int col) const { return (row + 1) * m_stride + (col + 1); }
+    int rowOf(int p) const            { return p / m_stride - 1; }
+    int colOf(int p) const            { return p % m_stride - 1; }
+    bool isOnBoard(int row, int col) const
+    {
+        return row >= 0 && row < m_size && col >= 0 && col < m_size;
+    }
+
+    int at(int p) const { return m_cells[(std::size_t)p]; }
+    int getCell(int row, int col) const;
+
+    // Stones of one color (Black or White) and the empty points as bit sets
+    // indexed by point.
+    const Bitboard& stonesOf(int color) const { return m_stones[color - 1]; }
+    Bitboard emptyPoints() const { return andNot(m_onBoard, m_stones[0] | m_stones[1]); }
+
+    // Neighbor offsets in the order up, down, left, right.
+    int neighbor(int p, int k) const { return p + m_offsets[k]; }
+
+    // 3x3 neighborhood of p: bits 2k..2k+1 hold the Cell of neighbor k, in
+    // the order up, down, left, right, up-left, down-right, up-right,
+    // down-left (neighbor k ^ 1 is the opposite of neighbor k). Edges show
+    // up as Wall.
+    std::uint16_t patternAt(int p) const { return m_pattern[(std::size_t)p]; }
+
+    // patternAt(p) plus bit 16 + k set when orthogonal neighbor k is a
+    // stone whose chain is in atari. 20 bits, O(1).
+    std::uint32_t patternKey(int p) const;
+
+    // Chain queries, O(1). Only meaningful on a stone.
+    int chainHead(int p) const { return m_chainHead[(std::size_t)p]; }
+    int chainNext(int p) const { return m_chainNext[(std::size_t)p]; }
+    int chainSize(int p) const { return m_chainSize[(std::size_t)m_chainHead[(std::size_t)p]]; }
+    int libertiesAt(int p) const;
+
+    bool isLegal(int p) const;
+
+    // Ok, Occupied, Ko or Suicide for an on-board point p.
+    MoveStatus moveStatus(int p) const;
+
+    // Plays for the side to move. Returns false and leaves the position
+    // untouched when the move is occupied, suicide or a ko recapture.
+    bool play(int p, int* captured = nullptr);
+    void pass();
+
+    void getLegalMoves(std::vector<int>& out) const;
+
+    // Make/unmake for search: same rules as play()/pass(), but the changes
+    // are recorded in u and undoMove(u) restores the position exactly.
+    // Moves must be undone in reverse order.
+    bool doMove(int p, Undo& u, int* captured = nullptr);
+    void doPass(Undo& u);
+    void undoMove(const Undo& u);
+
+    // Takes the whole chain at p off the board and credits the stones to
+    // the other side (used for dead-stone removal).
+    int removeGroup(int p);
+
+    // Same for a set of single stones; rebuilds all chains afterwards.
+    int removeStones(const std::vector<int>& points);
+
+    Score computeScore() const;
+
+private:
+    int m_size;
+    int m_stride;
+    int m_offsets[4];
+    int m_around[8];   // all eight neighbors, in patternAt() order
+
+    int m_toMove;
+    int m_koPoint;
+    int m_blackCaptured;
+    int m_whiteCaptured;
+    double m_komi;
+
+    std::uint64_t m_hash;
+
+    std::array<signed char, kMaxPoints> m_cells;
+    std::array<short, kMaxPoints>       m_chainHead;
+    std::array<short, kMaxPoints>       m_chainNext;
+    std::array<short, kMaxPoints>       m_chainSize;
+    std::array<short, kMaxPoints>       m_chainLibs;
+    std::array<std::uint16_t, kMaxPoints> m_pattern;
+
+    Bitboard m_stones[2];   // Black, White
+    Bitboard m_onBoard;
+    Bitboard m_reach[2];    // empty points reached by Black, White
+
+    void setCell(int p, int color);
+    void rebuildPatterns();
+
+    bool isLibertyOf(int q, int head) const;
+    void placeStone(int p, int color);
+    int  mergeChains(int a, int b);
+    int  captureChain(int head);
+    void uncaptureChain(int head, int color);
+    void creditCaptures(int color, int count);
+    void rebuildChains();
+
+    void updateReachAfterMove(int p, int color, int capturedCount,
+                              const Bitboard& opponentBefore);
+    bool keepsContact(int p, int color) const;
+    void refreshReach(const Bitboard& changed);
+
+    template <int N> bool  isLegalImpl(int p) const;
+    template <int N> void  getLegalMovesImpl(std::vector<int>& out) const;
+    template <int N> void  rebuildChainsImpl();
+    template <int N> void  placeReachImpl(int p, int color);
+    template <int N> void  refreshReachImpl(const Bitboard& changed);
+};
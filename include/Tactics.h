@@ -0,0 +1,29 @@
+#pragma once
+
+#include "SearchBoard.h"
+
+// Tactical queries answered from the chain and liberty bookkeeping of
+// SearchBoard instead of by playing moves out.
+namespace Tactics
+{
+    // The only liberty of the chain at p, which must be in atari.
+    int lastLiberty(const SearchBoard& board, int p);
+
+    // Most stones the side to move can capture with a single move. Same
+    // result as trying every legal move with doMove and taking the largest
+    // capture count, but only looks at the opponent chains in atari.
+    int maxCapture(const SearchBoard& board);
+
+    // Whether the chain at p is lost to a ladder. With its owner to move it
+    // must have one liberty, and no extension or capture of an adjacent
+    // chain in atari gets it to three liberties before it is captured; with
+    // the opponent to move it must have two, and some atari starts such a
+    // ladder (one liberty with the opponent to move is simply captured).
+    // Read with doMove/undoMove on a copy of board, so breakers of either
+    // color are seen as the ladder reaches them. Too long a ladder (see
+    // kLadderDepth / kLadderNodes) counts as an escape.
+    bool isLadderCaptured(const SearchBoard& board, int p);
+
+    constexpr int kLadderDepth = 160;   // plies; a ladder across 19x19 is about 70
+    constexpr int kLadderNodes = 400;   // doMove calls per reading
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Fixed-size hash table of search results for the alpha-beta search,
+// keyed by a 64-bit position hash (SearchBoard::getHash()).
+//
+// The table is an array of two-entry buckets. The first slot keeps the
+// deepest result seen for its bucket (results from an older search are
+// replaced regardless of depth), the second slot always takes the newest
+// store, so shallow results near the leaves do not push out the expensive
+// ones near the root.
+//
+// Several search threads may probe and store at the same time without
+// locks. Each slot is three atomic words and the first one holds the key
+// XOR the other two, so a slot torn by concurrent writes fails the key
+// check and reads as a miss.
+class TranspositionTable
+{
+public:
+    enum Bound : std::uint8_t
+    {
+        None,
+        Exact,   // value is the minimax value
+        Lower,   // search failed high: value <= true value
+        Upper    // search failed low:  value >= true value
+    };
+
+    struct Entry
+    {
+        std::uint64_t key   = 0;
+        double        value = 0.0;
+        std::int16_t  move  = -1;   // best point found, -1 if none
+        std::int8_t   depth = 0;
+        Bound         bound = None;
+        std::uint8_t  age   = 0;
+    };
+
+    // Size cap in megabytes; rounded down to a power of two number of buckets.
+    explicit TranspositionTable(std::size_t megabytes = 16);
+
+    // Not thread-safe: only call while no search is running.
+    void resize(std::size_t megabytes);
+    void clear();
+
+    // Marks the start of a new search; entries from older searches become
+    // the first to be replaced. Not thread-safe either.
+    void newSearch() { ++m_age; }
+
+    // Copies the entry stored for key into out; false if there is none.
+    bool probe(std::uint64_t key, Entry& out) const;
+
+    void store(std::uint64_t key, int depth, Bound bound, double value, int move);
+
+    std::size_t sizeInBytes() const { return m_count * sizeof(Bucket); }
+
+private:
+    struct Slot
+    {
+        std::atomic<std::uint64_t> check{0};   // key ^ value ^ meta
+        std::atomic<std::uint64_t> value{0};
+        std::atomic<std::uint64_t> meta{0};    // move, depth, bound, age
+    };
+
+    struct Bucket
+    {
+        Slot deep;
+        Slot recent;
+    };
+
+    std::unique_ptr<Bucket[]> m_buckets;
+    std::size_t               m_count = 0;
+    std::size_t               m_mask  = 0;
+    std::uint8_t              m_age   = 0;
+
+    static Entry load(const Slot& slot);
+    static void  save(Slot& slot, const Entry& e);
+};
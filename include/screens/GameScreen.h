@@ -3,6 +3,8 @@
 #include "Screen.h"
 
 #include <SFML/Graphics.hpp>
+#include <atomic>
+#include <future>
 #include <memory>
 #include <string>
 #include <utility>
@@ -17,6 +19,7 @@ public:
     using NavigateFn = std::function<void(const std::string&)>;
 
     explicit GameScreen(NavigateFn onNavigate);
+    ~GameScreen() override;
 
     void setBoardSize(int size);
     void setCurrentPlayer(int player);
@@ -34,6 +37,11 @@ private:
 
     void handleBoardClick(int mouseX, int mouseY);
 
+    // AI search runs on a worker thread over a copy of the game;
+    // update() picks up the result.
+    void startAIMove();
+    void cancelAIMove();
+
     
     void loadBoardTheme();
     void applyBoardThemeToRect();
@@ -54,7 +62,8 @@ private:
     bool vsAI;
     int  aiPlayerIndex;
     bool pendingAIMove;
-    float aiThinkTimer;
+    std::future<std::pair<int,int>> aiFuture;
+    std::atomic<bool>               aiCancel;
 
     sf::Font font;
 
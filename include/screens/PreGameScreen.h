@@ -43,6 +43,10 @@ private:
     Button btnEasy;
     Button btnMedium;
     Button btnHard;
+    Button btnMCTS;
+
+    // Pondering on/off (Hard and MCTS keep thinking on the player's turn)
+    Button btnPonder;
 
     Button btnStart;
 
@@ -53,7 +57,9 @@ private:
 
     int selectedBoard;  
     int selectedMode;   
+    bool ponder;
 
     std::vector<sf::Vector2f> boardBtnPositions;
-    std::array<sf::Vector2f, 4> modeBtnPositions;
+    std::array<sf::Vector2f, 5> modeBtnPositions;
+    sf::Vector2f ponderBtnPosition;
 };
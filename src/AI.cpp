@@ -1,14 +1,23 @@
 
 #include "AI.h"
+#include "Tactics.h"
+#include "Patterns.h"
 #include <random>
 #include <algorithm>
 #include <cmath>
+#include <array>
+#include <chrono>
 
 GoAI::GoAI(AIDifficulty diff)
     : m_diff(diff)
 {}
 
+GoAI::~GoAI() {
+    stopPondering();
+}
+
 void GoAI::setDifficulty(AIDifficulty diff) {
+    stopPondering();
     m_diff = diff;
 }
 
@@ -16,88 +25,245 @@ AIDifficulty GoAI::getDifficulty() const {
     return m_diff;
 }
 
-std::pair<int,int> GoAI::chooseMove(const GoGame& game, int aiColor)
+void GoAI::setMCTSOptions(const MCTS::Options& options) {
+    stopPondering();
+    m_mcts.setOptions(options);
+}
+
+void GoAI::setThreads(int threads) {
+    stopPondering();
+    m_threads = threads;
+    MCTS::Options options = m_mcts.getOptions();
+    options.threads = threads;
+    m_mcts.setOptions(options);
+}
+
+int GoAI::hardThreads() const {
+    if (m_threads > 0)
+        return m_threads;
+    return std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+void GoAI::setSearchLimits(AIDifficulty diff, const SearchLimits& limits) {
+    stopPondering();
+    if (diff == AIDifficulty::Medium) {
+        m_mediumLimits = limits;
+    } else if (diff == AIDifficulty::Hard) {
+        m_hardLimits = limits;
+    } else if (diff == AIDifficulty::MCTS) {
+        MCTS::Options options = m_mcts.getOptions();
+        options.timeLimitMs = limits.timeMs;
+        m_mcts.setOptions(options);
+    }
+}
+
+GoAI::SearchLimits GoAI::getSearchLimits(AIDifficulty diff) const {
+    if (diff == AIDifficulty::Medium) return m_mediumLimits;
+    if (diff == AIDifficulty::Hard)   return m_hardLimits;
+    if (diff == AIDifficulty::MCTS)   return {m_mcts.getOptions().timeLimitMs, 0};
+    return {0, 1};
+}
+
+// Hết giờ hoặc bị hủy? Chỉ kiểm tra mỗi 1024 node.
+bool GoAI::outOfTime(SearchContext& ctx) {
+    if (ctx.timeUp)
+        return true;
+    if ((++ctx.nodes & 1023) == 0) {
+        if ((ctx.stop && ctx.stop->load(std::memory_order_relaxed)) ||
+            m_helpersStop.load(std::memory_order_relaxed) ||
+            (m_hasDeadline && Clock::now() >= m_deadline))
+            ctx.timeUp = true;
+    }
+    return ctx.timeUp;
+}
+
+void GoAI::setHashSizeMB(std::size_t megabytes) {
+    stopPondering();
+    m_tt.resize(megabytes);
+}
+
+// Khóa cho bảng transposition: getHash() (quân + lượt + ko) cộng thêm số quân
+// bị ăn, cỡ bàn và màu của AI, vì giá trị evaluatePosition phụ thuộc cả những thứ đó.
+static std::uint64_t searchKey(const SearchBoard& state, int aiColor)
+{
+    std::uint64_t k = state.getHash();
+    if (aiColor == GoGame::White)
+        k ^= 0xD6E8FEB86659FD93ull;
+    k ^= (std::uint64_t)state.getBlackCaptured() * 0x9E3779B97F4A7C15ull;
+    k ^= (std::uint64_t)state.getWhiteCaptured() * 0xC2B2AE3D27D4EB4Full;
+    k ^= (std::uint64_t)state.getBoardSize()     * 0x165667B19E3779F9ull;
+    return k;
+}
+
+// Nước hợp lệ ở gốc. Superko chỉ kiểm tra ở gốc (SearchBoard không giữ lịch sử)
+static void rootMoves(const GoGame& game, const SearchBoard& root, std::vector<int>& moves)
 {
-    auto legalMoves = game.getLegalMoves();
+    root.getLegalMoves(moves);
+    if (game.isSuperko()) {
+        moves.erase(
+            std::remove_if(moves.begin(), moves.end(),
+                           [&](int p) {
+                               return game.repeatsPosition(root.rowOf(p), root.colOf(p));
+                           }),
+            moves.end());
+    }
+}
+
+void GoAI::setPondering(bool enabled) {
+    if (!enabled)
+        stopPondering();
+    m_ponderEnabled = enabled;
+}
+
+void GoAI::startPondering(const GoGame& game, int aiColor) {
+    stopPondering();
+    if (!m_ponderEnabled || !game.isPlaying() || game.isGameOver())
+        return;
+    if (m_diff != AIDifficulty::Hard && m_diff != AIDifficulty::MCTS)
+        return;
+
+    m_ponderStop = false;
+    m_ponderThread = std::thread(&GoAI::ponder, this, game, aiColor);
+}
+
+void GoAI::stopPondering() {
+    if (m_ponderThread.joinable()) {
+        m_ponderStop = true;
+        m_ponderThread.join();
+    }
+}
+
+// Chạy trên luồng nền trong lượt của người chơi (game: người chơi đang đi).
+void GoAI::ponder(GoGame game, int aiColor) {
+    SearchBoard root = SearchBoard::fromGame(game);
+
+    std::vector<int> moves;
+    rootMoves(game, root, moves);
+    if (moves.empty())
+        return;
+
+    // MCTS: nuôi cây cho các nước đáp; lượt sau lấy lại nhánh khớp
+    if (m_diff == AIDifficulty::MCTS) {
+        m_mcts.ponder(root, moves, &m_ponderStop);
+        return;
+    }
+
+    // Hard: đào sâu dần từ vị trí của người chơi để điền sẵn bảng transposition
+    m_hasDeadline  = false;
+    m_main.stop    = &m_ponderStop;
+    m_main.timeUp  = false;
+    resetMoveOrdering(m_main);
+    for (int depth = 1; depth <= std::max(1, m_hardLimits.maxDepth); ++depth) {
+        minimaxAlphaBeta(m_main, root, depth, false, aiColor, -1e18, 1e18, 0);
+        if (m_main.timeUp)
+            break;
+    }
+}
+
+std::pair<int,int> GoAI::chooseMove(const GoGame& game, int aiColor,
+                                    const std::atomic<bool>* stop)
+{
+    stopPondering();
+
+    Clock::time_point start = Clock::now();
+    m_nodes = 0;
+
+    if (!game.isPlaying() || game.isGameOver())
+        return {-1, -1};
+
+    // Tìm kiếm trên SearchBoard (không kéo theo history của GoGame).
+    // Chỉ copy một lần, sau đó doMove/undoMove tại chỗ.
+    SearchBoard root = SearchBoard::fromGame(game);
+    SearchBoard::Undo undo;
+
+    std::vector<int> legalMoves;
+    rootMoves(game, root, legalMoves);
     if (legalMoves.empty())
         return {-1, -1};   // pass
 
     
+    // MCTS: UCT + random playouts
+    
+    if (m_diff == AIDifficulty::MCTS) {
+        int p = m_mcts.search(root, legalMoves, stop);
+        if (p < 0)
+            return {-1, -1};
+        return {root.rowOf(p), root.colOf(p)};
+    }
+
+    
     // EASY: 1-ply greedy
     
     if (m_diff == AIDifficulty::Easy) {
         double bestScore = -1e18;
-        std::pair<int,int> bestMove = legalMoves[0];
+        int bestMove = legalMoves[0];
 
-        for (auto [r, c] : legalMoves) {
-            GoGame child = game;
-            auto res = child.playMove(r, c);
-            if (!res.ok) continue;
+        for (int p : legalMoves) {
+            int captured = 0;
+            if (!root.doMove(p, undo, &captured)) continue;
 
-            double s = evaluatePosition(child, aiColor);
+            double s = evaluatePosition(root, aiColor);
 
             // Băn càng nhiều quân càng ngon
-            s += res.captured * 2.5;
+            s += captured * 2.5;
 
             // PHẠT nước chơi xong mà group còn 1 liberty và không ăn quân
-            int libs = child.countGroupLiberties(r, c);
-            if (libs == 1 && res.captured == 0)
+            int libs = root.libertiesAt(p);
+            if (libs == 1 && captured == 0)
                 s -= 4.0;
 
+            // Còn 2 liberty nhưng đối thủ bắt được bằng thang (ladder)
+            if (libs == 2 && Tactics::isLadderCaptured(root, p))
+                s -= root.chainSize(p) * 2.5;
+
+            root.undoMove(undo);
+
             if (s > bestScore) {
                 bestScore = s;
-                bestMove  = {r, c};
+                bestMove  = p;
             }
         }
 
-        return bestMove;
+        return {root.rowOf(bestMove), root.colOf(bestMove)};
     }
 
     
     // MEDIUM & HARD: đánh giá + minimax
     
-    struct Candidate {
-        int r, c;
-        double eval;
-    };
-
     std::vector<Candidate> candidates;
     candidates.reserve(legalMoves.size());
 
     // Đánh giá nhanh từng nước 1-ply bằng evaluatePosition
-    for (auto [r, c] : legalMoves) {
-        GoGame child = game;
-        auto res = child.playMove(r, c);
-        if (!res.ok) continue;
+    for (int p : legalMoves) {
+        if (stop && stop->load(std::memory_order_relaxed))
+            return {-1, -1};
 
-        double e = evaluatePosition(child, aiColor);
+        int captured = 0;
+        if (!root.doMove(p, undo, &captured)) continue;
+
+        double e = evaluatePosition(root, aiColor);
 
         // Thưởng nước ăn quân
-        e += res.captured * 2.5;
+        e += captured * 2.5;
 
         // Phạt nước còn 1 liberty và không ăn gì
-        int libs = child.countGroupLiberties(r, c);
-        if (libs == 1 && res.captured == 0)
+        int libs = root.libertiesAt(p);
+        if (libs == 1 && captured == 0)
             e -= 4.0;
 
+        // Thoát atari mà vẫn chết thang (ladder): đối thủ ăn cả chuỗi
+        if (libs == 2 && Tactics::isLadderCaptured(root, p))
+            e -= root.chainSize(p) * 2.0;
+
 
          // Phạt nước dễ bị đối thủ ăn ngay ở lượt sau
-        int maxOppCapture = 0;
-        {
-            GoGame afterMyMove = child;
-            auto oppMoves = afterMyMove.getLegalMoves();
-            for (auto [orow, ocol] : oppMoves) {
-                GoGame tmp = afterMyMove;
-                auto oppRes = tmp.playMove(orow, ocol);
-                if (!oppRes.ok) continue;
-                if (oppRes.captured > maxOppCapture)
-                    maxOppCapture = oppRes.captured;
-            }
-        }
+         // (chỉ xét các chuỗi đang bị atari, không thử từng nước của đối thủ)
+        int maxOppCapture = Tactics::maxCapture(root);
+        root.undoMove(undo);
         // phạt 2
         e -= maxOppCapture * 2.0;
 
-        candidates.push_back({r, c, e});
+        candidates.push_back({p, e});
     }
 
     if (candidates.empty())
@@ -109,33 +275,18 @@ std::pair<int,int> GoAI::chooseMove(const GoGame& game, int aiColor)
                   return a.eval > b.eval;
               });
 
-    // Chọn K và depth theo độ khó + kích thước bàn
+    // Chọn K theo độ khó + kích thước bàn (độ sâu do iterative deepening quyết định)
     int bs = game.getBoardSize();
     int K;
-    int depth;
 
     if (m_diff == AIDifficulty::Medium) {
-        if (bs <= 9) {          // 9x9
-            K = 7;
-            depth = 2;
-        } else if (bs <= 13) {  // 13x13
-            K = 6;
-            depth = 2;
-        } else {                // 19x19
-            K = 5;
-            depth = 2;
-        }
+        if (bs <= 9)       K = 7;   // 9x9
+        else if (bs <= 13) K = 6;   // 13x13
+        else               K = 5;   // 19x19
     } else { // Hard
-        if (bs <= 9) {          // 9x9
-            K = 7;
-            depth = 3;
-        } else if (bs <= 13) {  // 13x13
-            K = 5;
-            depth = 3;
-        } else {                // 19x19
-            K = 3;
-            depth = 3;
-        }
+        if (bs <= 9)       K = 7;   // 9x9
+        else if (bs <= 13) K = 5;   // 13x13
+        else               K = 3;   // 19x19
     }
 
     // Giới hạn K theo số TH thực tế
@@ -144,46 +295,155 @@ std::pair<int,int> GoAI::chooseMove(const GoGame& game, int aiColor)
     else
         K = (int)candidates.size();  // đề phòng ít hơn K
 
-    // Minimax / Alpha-Beta trên các ứng viên
-    double bestScore = -1e18;
-    std::pair<int,int> bestMove = {candidates[0].r, candidates[0].c};
+    const SearchLimits& limits = (m_diff == AIDifficulty::Medium ? m_mediumLimits : m_hardLimits);
+    m_hasDeadline = limits.timeMs > 0;
+    m_deadline    = start + std::chrono::milliseconds(limits.timeMs);
+
+    m_main.stop   = stop;
+    m_main.nodes  = 0;
+    m_main.timeUp = false;
+
+    RootResult result;
+    result.move = candidates[0].p;
+
+    // Hard: Lazy SMP. Các luồng phụ tìm cùng gốc với độ sâu bắt đầu và thứ
+    // tự ứng viên khác nhau; kết quả đi qua bảng transposition chung và
+    // result. Luồng chính xong thì dừng hết các luồng phụ.
+    std::vector<std::thread> helpers;
+    if (m_diff == AIDifficulty::Hard) {
+        m_tt.newSearch();
+        resetMoveOrdering(m_main);
+
+        int count = (K > 1 ? hardThreads() - 1 : 0);
+        m_helpers.resize((std::size_t)count);
+        m_helpersStop = false;
+        for (int i = 1; i <= count; ++i) {
+            SearchContext& ctx = m_helpers[(std::size_t)(i - 1)];
+            ctx.stop   = stop;
+            ctx.nodes  = 0;
+            ctx.timeUp = false;
+            resetMoveOrdering(ctx);
+
+            std::vector<Candidate> order = candidates;
+            std::rotate(order.begin(), order.begin() + i % K, order.end());
+            helpers.emplace_back(&GoAI::searchRoot, this, std::ref(ctx), root, std::move(order),
+                                 aiColor, 2 + i % 2, false, start, std::ref(result));
+        }
+    }
 
-    for (const Candidate& cand : candidates) {
-        GoGame child = game;
-        auto res = child.playMove(cand.r, cand.c);
-        if (!res.ok) continue;
+    searchRoot(m_main, root, candidates, aiColor, 1, true, start, result);
 
-        double score = 0.0;
-        if (depth <= 0) {
-            score = evaluatePosition(child, aiColor);
-        } else if (m_diff == AIDifficulty::Medium) {
-            score = minimax(child, depth - 1, false, aiColor);
-        } else {
-            score = minimaxAlphaBeta(child, depth - 1, false,
-                                     aiColor, -1e18, 1e18);
+    m_helpersStop = true;
+    for (std::thread& t : helpers)
+        t.join();
+    m_helpersStop = false;
+
+    m_nodes = m_main.nodes;
+    for (std::size_t i = 0; i < helpers.size(); ++i)
+        m_nodes += m_helpers[i].nodes;
+
+    return {root.rowOf(result.move), root.colOf(result.move)};
+}
+
+// Iterative deepening trên các ứng viên ở gốc: độ sâu firstDepth, firstDepth + 1, ...
+// tới khi hết giờ, bị dừng hoặc chạm maxDepth. Chỉ dùng kết quả của vòng đã
+// chạy xong; độ sâu 1 chỉ gọi evaluatePosition nên luôn xong.
+void GoAI::searchRoot(SearchContext& ctx, SearchBoard root, std::vector<Candidate> candidates,
+                      int aiColor, int firstDepth, bool isMain,
+                      Clock::time_point start, RootResult& result)
+{
+    const SearchLimits& limits = (m_diff == AIDifficulty::Medium ? m_mediumLimits : m_hardLimits);
+    int K = (int)candidates.size();
+    SearchBoard::Undo undo;
+
+    for (int depth = firstDepth; depth <= std::max(1, limits.maxDepth); ++depth) {
+        double bestScore = -1e18;
+        int bestIndex = -1;
+
+        for (int i = 0; i < K; ++i) {
+            if (!root.doMove(candidates[i].p, undo)) continue;
+
+            double score = 0.0;
+            if (depth == 1) {
+                score = evaluatePosition(root, aiColor);
+            } else if (m_diff == AIDifficulty::Medium) {
+                score = minimax(ctx, root, depth - 1, false, aiColor);
+            } else {
+                // Chỉ cần biết ứng viên có hơn nước tốt nhất hiện tại không
+                score = minimaxAlphaBeta(ctx, root, depth - 1, false,
+                                         aiColor, bestScore, 1e18, 1);
+            }
+            root.undoMove(undo);
+
+            if (ctx.timeUp) break;
+
+            if (score > bestScore) {
+                bestScore = score;
+                bestIndex = i;
+            }
         }
 
-        if (score > bestScore) {
-            bestScore = score;
-            bestMove  = {cand.r, cand.c};
+        if (ctx.timeUp || bestIndex < 0) break;
+
+        {
+            // Cùng độ sâu thì giữ nước của luồng chính
+            std::lock_guard<std::mutex> lock(result.lock);
+            if (depth > result.depth || (isMain && depth == result.depth)) {
+                result.depth = depth;
+                result.move  = candidates[bestIndex].p;
+            }
         }
-    }
 
-    return bestMove;
+        // Nước tốt nhất lên đầu để vòng sau cắt tỉa được nhiều hơn
+        std::rotate(candidates.begin(), candidates.begin() + bestIndex,
+                    candidates.begin() + bestIndex + 1);
+
+        if (K == 1) break;
+
+        // Vòng sau tốn hơn hẳn vòng này: đã dùng quá nửa thời gian thì dừng
+        if (isMain && m_hasDeadline &&
+            (Clock::now() - start) * 2 > std::chrono::milliseconds(limits.timeMs))
+            break;
+    }
 }
 
 
 
+// Trọng số trung tâm theo điểm (point của SearchBoard), tính một lần cho mỗi cỡ bàn
+static const std::array<int, SearchBoard::kMaxPoints>& centerWeights(int n)
+{
+    static const auto build = [](int size) {
+        std::array<int, SearchBoard::kMaxPoints> w{};
+        SearchBoard board(size);
+        int center = size / 2;
+        for (int r = 0; r < size; ++r) {
+            for (int c = 0; c < size; ++c) {
+                int manDist = std::abs(r - center) + std::abs(c - center);
+                w[(std::size_t)board.point(r, c)] = std::max(0, size - manDist);
+            }
+        }
+        return w;
+    };
+
+    static const std::array<int, SearchBoard::kMaxPoints> w9  = build(9);
+    static const std::array<int, SearchBoard::kMaxPoints> w13 = build(13);
+    static const std::array<int, SearchBoard::kMaxPoints> w19 = build(19);
+
+    if (n == 13) return w13;
+    if (n == 19) return w19;
+    return w9;
+}
+
 //  - Territory + captures (JapaneseScore)
 //  - Ưu tiên trung tâm
 //  - Bonus ô giữa
 //  - Neighbor 
 
 
-double GoAI::evaluatePosition(const GoGame& game, int aiColor) const
+double GoAI::evaluatePosition(const SearchBoard& game, int aiColor) const
 {
     // Territory + captures theo luật
-    GoGame::JapaneseScore js = game.computeJapaneseScore();
+    SearchBoard::Score js = game.computeScore();
 
     double blackScore = js.blackTerritory + js.blackCaptures;
     double whiteScore = js.whiteTerritory + js.whiteCaptures + js.komi;
@@ -198,42 +458,33 @@ double GoAI::evaluatePosition(const GoGame& game, int aiColor) const
     double score = baseDiff * 0.6;
 
     //  ưu tiên vị trí gần trung tâm + kết nối chuỗi
+    // Chỉ duyệt các quân đang có trên bàn (bitboard), không quét cả bàn.
     int n = game.getBoardSize();
     int center = n / 2;
+    int stride = game.getStride();
 
-    // neighbor: chỉ xét 2 hướng (phải, xuống) để tránh đếm đôi
-    static const int dr2[2] = {0, 1};
-    static const int dc2[2] = {1, 0};
+    const std::array<int, SearchBoard::kMaxPoints>& weights = centerWeights(n);
 
-    for (int r = 0; r < n; ++r) {
-        for (int c = 0; c < n; ++c) {
-            int v = game.getCell(r, c);
-            if (v == GoGame::Empty) continue;
+    int myColor  = aiColor;
+    int oppColor = (aiColor == GoGame::Black ? GoGame::White : GoGame::Black);
 
-            int sign = (v == aiColor ? +1 : -1);
+    const Bitboard& mine   = game.stonesOf(myColor);
+    const Bitboard& theirs = game.stonesOf(oppColor);
 
-            // ƯU TIÊN GẦN TRUNG TÂM
-            int manDist = std::abs(r - center) + std::abs(c - center);
-            double centerWeight = std::max(0, n - manDist); // càng gần càng lớn
-            double wCenter = 0.08 * centerWeight;
+    // ƯU TIÊN GẦN TRUNG TÂM: trọng số max(0, n - khoảng cách Manhattan)
+    int centerDiff = 0;
+    mine.forEach([&](int p) { centerDiff += weights[(std::size_t)p]; });
+    theirs.forEach([&](int p) { centerDiff -= weights[(std::size_t)p]; });
 
-            score += sign * wCenter;
+    score += 0.08 * centerDiff;
 
-            // thưởng khi 2 quân cùng màu đứng cạnh nhau
-            for (int k = 0; k < 2; ++k) { // phải + xuống
-                int nr = r + dr2[k];
-                int nc = c + dc2[k];
-                if (nr < 0 || nr >= n || nc < 0 || nc >= n) continue;
+    // thưởng khi 2 quân cùng màu đứng cạnh nhau (phải + xuống, không đếm đôi)
+    int pairDiff = (mine & mine.shiftedDown(1)).count()
+                 + (mine & mine.shiftedDown(stride)).count()
+                 - (theirs & theirs.shiftedDown(1)).count()
+                 - (theirs & theirs.shiftedDown(stride)).count();
 
-                int v2 = game.getCell(nr, nc);
-                if (v2 == v) {
-                    // cùng màu, tạo “chuỗi”
-                    double wChain = 0.3;  // nhỏ 
-                    score += sign * wChain;
-                }
-            }
-        }
-    }
+    score += 0.3 * pairDiff;
 
     // 3) BONUS riêng cho đúng ô giữa 
     int cv = game.getCell(center, center);
@@ -249,26 +500,31 @@ double GoAI::evaluatePosition(const GoGame& game, int aiColor) const
 //  MINIMAX THƯỜNG
 
 
-double GoAI::minimax(GoGame state, int depth, bool maximizingPlayer,
-                     int aiColor)
+double GoAI::minimax(SearchContext& ctx, SearchBoard& state, int depth,
+                     bool maximizingPlayer, int aiColor)
 {
-    if (depth == 0 || state.isGameOver()) {
+    if (outOfTime(ctx))
+        return 0.0;
+
+    if (depth == 0) {
         return evaluatePosition(state, aiColor);
     }
 
-    auto moves = state.getLegalMoves();
+    std::vector<int> moves;
+    state.getLegalMoves(moves);
     if (moves.empty()) {
         return evaluatePosition(state, aiColor);
     }
 
     double bestVal = maximizingPlayer ? -1e18 : 1e18;
 
-    for (auto [r, c] : moves) {
-        GoGame child = state;
-        auto res = child.playMove(r, c);
-        if (!res.ok) continue;
+    SearchBoard::Undo undo;
+    for (int p : moves) {
+        if (!state.doMove(p, undo)) continue;
 
-        double val = minimax(child, depth - 1, !maximizingPlayer, aiColor);
+        double val = minimax(ctx, state, depth - 1, !maximizingPlayer, aiColor);
+        state.undoMove(undo);
+        if (ctx.timeUp) return 0.0;
 
         if (maximizingPlayer)
             bestVal = std::max(bestVal, val);
@@ -283,45 +539,274 @@ double GoAI::minimax(GoGame state, int depth, bool maximizingPlayer,
 //  MINIMAX + ALPHA-BETA (Hard)
 
 
-double GoAI::minimaxAlphaBeta(GoGame state, int depth, bool maximizingPlayer,
-                              int aiColor, double alpha, double beta)
+double GoAI::minimaxAlphaBeta(SearchContext& ctx, SearchBoard& state, int depth,
+                              bool maximizingPlayer, int aiColor,
+                              double alpha, double beta, int ply)
 {
-    if (depth == 0 || state.isGameOver()) {
-        return evaluatePosition(state, aiColor);
+    // Hết giờ: kết quả bị bỏ, không ghi vào bảng
+    if (outOfTime(ctx))
+        return 0.0;
+
+    // Lá: evaluatePosition rẻ hơn một lần tra bảng; còn đang đánh nhau
+    // (có chuỗi bị atari) thì đi tiếp bằng quiescence
+    if (depth == 0) {
+        ctx.qBudget = m_hardLimits.quiescenceNodes;
+        return quiescence(ctx, state, maximizingPlayer, aiColor, alpha, beta, 0);
     }
 
-    auto moves = state.getLegalMoves();
+    // Tra bảng transposition trước
+    std::uint64_t key = searchKey(state, aiColor);
+    int ttMove = -1;
+    TranspositionTable::Entry e;
+    if (m_tt.probe(key, e)) {
+        ttMove = e.move;
+        if (e.depth >= depth) {
+            if (e.bound == TranspositionTable::Exact)
+                return e.value;
+            if (e.bound == TranspositionTable::Lower)
+                alpha = std::max(alpha, e.value);
+            else if (e.bound == TranspositionTable::Upper)
+                beta = std::min(beta, e.value);
+            if (beta <= alpha)
+                return e.value;
+        }
+    }
+
+    std::vector<int> moves;
+    state.getLegalMoves(moves);
     if (moves.empty()) {
-        return evaluatePosition(state, aiColor);
+        double val = evaluatePosition(state, aiColor);
+        m_tt.store(key, depth, TranspositionTable::Exact, val, -1);
+        return val;
     }
 
+    orderMoves(ctx, state, moves, ttMove, ply);
+
+    double alphaOrig = alpha;
+    double betaOrig  = beta;
+    int bestMove = -1;
+
+    SearchBoard::Undo undo;
+    double bestVal;
     if (maximizingPlayer) {
-        double bestVal = -1e18;
-        for (auto [r, c] : moves) {
-            GoGame child = state;
-            auto res = child.playMove(r, c);
-            if (!res.ok) continue;
-
-            double val = minimaxAlphaBeta(child, depth - 1, false,
-                                          aiColor, alpha, beta);
-            bestVal = std::max(bestVal, val);
-            alpha   = std::max(alpha, bestVal);
-            if (beta <= alpha) break;
+        bestVal = -1e18;
+        for (int p : moves) {
+            if (!state.doMove(p, undo)) continue;
+
+            double val = minimaxAlphaBeta(ctx, state, depth - 1, false,
+                                          aiColor, alpha, beta, ply + 1);
+            state.undoMove(undo);
+            if (ctx.timeUp) return 0.0;
+            if (val > bestVal) {
+                bestVal  = val;
+                bestMove = p;
+            }
+            alpha = std::max(alpha, bestVal);
+            if (beta <= alpha) {
+                recordCutoff(ctx, state, p, depth, ply);
+                break;
+            }
         }
-        return bestVal;
     } else {
-        double bestVal = 1e18;
-        for (auto [r, c] : moves) {
-            GoGame child = state;
-            auto res = child.playMove(r, c);
-            if (!res.ok) continue;
-
-            double val = minimaxAlphaBeta(child, depth - 1, true,
-                                          aiColor, alpha, beta);
+        bestVal = 1e18;
+        for (int p : moves) {
+            if (!state.doMove(p, undo)) continue;
+
+            double val = minimaxAlphaBeta(ctx, state, depth - 1, true,
+                                          aiColor, alpha, beta, ply + 1);
+            state.undoMove(undo);
+            if (ctx.timeUp) return 0.0;
+            if (val < bestVal) {
+                bestVal  = val;
+                bestMove = p;
+            }
+            beta = std::min(beta, bestVal);
+            if (beta <= alpha) {
+                recordCutoff(ctx, state, p, depth, ply);
+                break;
+            }
+        }
+    }
+
+    TranspositionTable::Bound bound = TranspositionTable::Exact;
+    if (bestVal <= alphaOrig)
+        bound = TranspositionTable::Upper;
+    else if (bestVal >= betaOrig)
+        bound = TranspositionTable::Lower;
+    m_tt.store(key, depth, bound, bestVal, bestMove);
+
+    return bestVal;
+}
+
+
+//  QUIESCENCE SEARCH
+//  Ở lá: lấy evaluatePosition làm mốc (stand pat), chỉ đi tiếp các nước
+//  ăn quân / thoát atari cho tới khi hết đánh nhau, hết ngân sách node
+//  hoặc chạm kMaxQuiescenceDepth.
+
+double GoAI::quiescence(SearchContext& ctx, SearchBoard& state, bool maximizingPlayer,
+                        int aiColor, double alpha, double beta, int qDepth)
+{
+    double standPat = evaluatePosition(state, aiColor);
+    if (qDepth >= kMaxQuiescenceDepth || ctx.qBudget <= 0)
+        return standPat;
+
+    if (maximizingPlayer) {
+        if (standPat >= beta) return standPat;
+        alpha = std::max(alpha, standPat);
+    } else {
+        if (standPat <= alpha) return standPat;
+        beta = std::min(beta, standPat);
+    }
+
+    std::vector<int> moves;
+    tacticalMoves(state, moves);
+
+    double bestVal = standPat;
+    SearchBoard::Undo undo;
+    for (int p : moves) {
+        if (ctx.qBudget <= 0 || outOfTime(ctx)) break;
+
+        int captured = 0;
+        if (!state.doMove(p, undo, &captured)) continue;
+
+        // Thoát atari mà vẫn chỉ còn 1 khí thì không tính
+        if (captured == 0 && state.libertiesAt(p) < 2) {
+            state.undoMove(undo);
+            continue;
+        }
+
+        --ctx.qBudget;
+        double val = quiescence(ctx, state, !maximizingPlayer, aiColor, alpha, beta, qDepth + 1);
+        state.undoMove(undo);
+        if (ctx.timeUp) return 0.0;
+
+        if (maximizingPlayer) {
+            bestVal = std::max(bestVal, val);
+            alpha   = std::max(alpha, bestVal);
+        } else {
             bestVal = std::min(bestVal, val);
             beta    = std::min(beta, bestVal);
-            if (beta <= alpha) break;
         }
-        return bestVal;
+        if (beta <= alpha) break;
     }
+
+    return bestVal;
+}
+
+// Nước chiến thuật cho bên đang đi: ăn chuỗi đối thủ đang bị atari (chuỗi
+// lớn trước), rồi kéo dài chuỗi của mình đang bị atari.
+void GoAI::tacticalMoves(const SearchBoard& state, std::vector<int>& moves) const
+{
+    int color    = state.getCurrentColor();
+    int oppColor = (color == GoGame::Black ? GoGame::White : GoGame::Black);
+
+    std::vector<std::pair<int, int>> captures;   // (số quân, điểm)
+    state.stonesOf(oppColor).forEach([&](int s) {
+        if (state.chainHead(s) == s && state.libertiesAt(s) == 1)
+            captures.push_back({state.chainSize(s), Tactics::lastLiberty(state, s)});
+    });
+    std::sort(captures.begin(), captures.end(),
+              [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+                  return a.first > b.first;
+              });
+
+    moves.clear();
+    for (const std::pair<int, int>& c : captures)
+        if (std::find(moves.begin(), moves.end(), c.second) == moves.end())
+            moves.push_back(c.second);
+
+    state.stonesOf(color).forEach([&](int s) {
+        if (state.chainHead(s) == s && state.libertiesAt(s) == 1) {
+            int q = Tactics::lastLiberty(state, s);
+            if (std::find(moves.begin(), moves.end(), q) == moves.end())
+                moves.push_back(q);
+        }
+    });
+}
+
+
+//  SẮP XẾP NƯỚC CHO ALPHA-BETA
+//  Thứ tự: nước trong bảng transposition (vòng trước), ăn quân, thoát atari
+//  (trừ chuỗi chết thang), 2 killer của ply, rồi theo bảng history (cộng
+//  trọng số hình 3x3).
+
+void GoAI::orderMoves(const SearchContext& ctx, const SearchBoard& state,
+                      std::vector<int>& moves, int ttMove, int ply) const
+{
+    int color    = state.getCurrentColor();
+    int oppColor = (color == GoGame::Black ? GoGame::White : GoGame::Black);
+
+    const std::array<int, 2>& killers = ctx.killers[(std::size_t)std::min(ply, kMaxPly - 1)];
+    const std::array<int, SearchBoard::kMaxPoints>& history = ctx.history[(std::size_t)(color - 1)];
+
+    std::vector<std::pair<long long, int>> scored;
+    scored.reserve(moves.size());
+
+    for (int p : moves) {
+        long long s = history[(std::size_t)p];
+
+        if (p == ttMove) {
+            s = 1LL << 40;
+        } else {
+            int captured = 0;
+            bool escape  = false;
+            for (int k = 0; k < 4; ++k) {
+                int q = state.neighbor(p, k);
+                int v = state.at(q);
+                if (v == oppColor && state.libertiesAt(q) == 1)
+                    captured += state.chainSize(q);
+                else if (v == color && state.libertiesAt(q) == 1 && !escape)
+                    escape = !Tactics::isLadderCaptured(state, q);
+            }
+
+            if (captured > 0)          s += (1LL << 36) + captured;
+            else if (escape)           s += 1LL << 35;
+            else if (p == killers[0])  s += 1LL << 34;
+            else if (p == killers[1])  s += 1LL << 33;
+            else                       s += Patterns::weight(state, p);
+        }
+
+        scored.push_back({s, p});
+    }
+
+    // stable: cùng điểm thì giữ thứ tự hàng - cột
+    std::stable_sort(scored.begin(), scored.end(),
+                     [](const std::pair<long long, int>& a, const std::pair<long long, int>& b) {
+                         return a.first > b.first;
+                     });
+
+    for (std::size_t i = 0; i < scored.size(); ++i)
+        moves[i] = scored[i].second;
+}
+
+// Nước gây cắt tỉa: thành killer của ply (nếu không phải nước ăn quân) và
+// được cộng điểm history theo độ sâu.
+void GoAI::recordCutoff(SearchContext& ctx, const SearchBoard& state, int p, int depth, int ply)
+{
+    int color = state.getCurrentColor();
+    ctx.history[(std::size_t)(color - 1)][(std::size_t)p] += depth * depth;
+
+    int oppColor = (color == GoGame::Black ? GoGame::White : GoGame::Black);
+    for (int k = 0; k < 4; ++k) {
+        int q = state.neighbor(p, k);
+        if (state.at(q) == oppColor && state.libertiesAt(q) == 1)
+            return;
+    }
+
+    std::array<int, 2>& killers = ctx.killers[(std::size_t)std::min(ply, kMaxPly - 1)];
+    if (killers[0] != p) {
+        killers[1] = killers[0];
+        killers[0] = p;
+    }
+}
+
+// Đầu mỗi lần tìm: xóa killer, giảm nửa history để nước cũ nhạt dần.
+void GoAI::resetMoveOrdering(SearchContext& ctx)
+{
+    for (std::array<int, 2>& k : ctx.killers)
+        k = {-1, -1};
+    for (std::array<int, SearchBoard::kMaxPoints>& h : ctx.history)
+        for (int& v : h)
+            v /= 2;
 }
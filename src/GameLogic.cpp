@@ -1,11 +1,9 @@
-
 #include "GameLogic.h"
 
 #include <fstream>
-#include <algorithm> 
-#include <queue>     
-#include <cmath>     
-#include <iostream>  
+#include <algorithm>
+#include <cmath>
+#include <iostream>
 
 GoGame::GoGame(int boardSize)
 {
@@ -14,277 +12,85 @@ GoGame::GoGame(int boardSize)
 
 void GoGame::reset(int boardSize)
 {
-    if (boardSize != 9 && boardSize != 13 && boardSize != 19)
+    if (!SearchBoard::isSupportedSize(boardSize))
         boardSize = 9;
 
-    m_boardSize        = boardSize;
-    m_currentPlayer    = 0;  
-    m_blackCaptured    = 0;
-    m_whiteCaptured    = 0;
+    double komi = m_board.getKomi();
+    m_board = SearchBoard(boardSize);
+    m_board.setKomi(komi);
+
     m_gameOver         = false;
     m_consecutivePasses = 0;
 
     m_phase = Phase::Playing;
-    int n = m_boardSize;
-    m_boardCells.assign((std::size_t)(n * n), 0);
-
-   
-    m_history.clear();
-    m_historyIndex = -1;
-
-    
-
-    saveState();
-
-    ensureBoardArray();
-
-    
-    m_prevBoardCells = m_boardCells;
-    m_hasPrevBoard   = true;
-
-    m_deadMarks.assign(m_boardCells.size(), false);
+    m_deadMarks.assign((std::size_t)(boardSize * boardSize), false);
 
+    clearHistory();
+    saveState(StepType::Start);
 }
 
 int GoGame::getCell(int row, int col) const
 {
-    if (row < 0 || col < 0 || row >= m_boardSize || col >= m_boardSize)
-        return 0;
-
-    int idx = row * m_boardSize + col;
-    if (idx < 0 || idx >= (int)m_boardCells.size())
-        return 0;
-
-    return m_boardCells[(std::size_t)idx];
+    return m_board.getCell(row, col);
 }
 
-void GoGame::ensureBoardArray()
+MoveStatus GoGame::tryMove(int row, int col, int* captured)
 {
-    int n = m_boardSize;
-    if (n != 9 && n != 13 && n != 19)
-        n = 9;
-
-    std::size_t expected = (std::size_t)(n * n);
-    if (m_boardCells.size() != expected)
-        m_boardCells.assign(expected, 0);
-}
-
+    if (captured)
+        *captured = 0;
 
-void GoGame::getGroupAndLiberties(
-    int row, int col, int color,
-    std::vector<int>& outGroup,
-    int& outLiberties,
-    const std::vector<int>& board
-) const
-{
-    outGroup.clear();
-    outLiberties = 0;
+    if (m_phase != Phase::Playing)
+        return MoveStatus::NotPlaying;
 
-    int n = m_boardSize;
-    if (n != 9 && n != 13 && n != 19)
-        n = 9;
+    if (m_gameOver)
+        return MoveStatus::GameOver;
 
-    if (row < 0 || row >= n || col < 0 || col >= n)
-        return;
+    if (!m_board.isOnBoard(row, col))
+        return MoveStatus::OutOfBoard;
 
-    int startIdx = row * n + col;
-    if (startIdx < 0 || startIdx >= n * n)
-        return;
+    int p = m_board.point(row, col);
 
-    if (color != Black && color != White)
-        return;
+    MoveStatus status = m_board.moveStatus(p);
+    if (status != MoveStatus::Ok)
+        return status;
 
-    if (board.empty() || board[(std::size_t)startIdx] != color)
-        return;
+    if (m_superko && repeatsPosition(row, col))
+        return MoveStatus::Superko;
 
-    std::vector<bool> visited((std::size_t)(n * n), false);
-    std::vector<bool> libertyMarked((std::size_t)(n * n), false);
+    applyMove(p, captured);
 
-    std::queue<int> q;
-    visited[(std::size_t)startIdx] = true;
-    q.push(startIdx);
+    saveState(StepType::Move, p);
 
-    const int dr[4] = {-1, 1, 0, 0};
-    const int dc[4] = {0, 0, -1, 1};
+    return MoveStatus::Ok;
+}
 
-    while (!q.empty())
+const char* GoGame::moveStatusMessage(MoveStatus status)
+{
+    switch (status)
     {
-        int idx = q.front();
-        q.pop();
-
-        outGroup.push_back(idx);
-
-        int r = idx / n;
-        int c = idx % n;
-
-        for (int k = 0; k < 4; ++k)
-        {
-            int nr = r + dr[k];
-            int nc = c + dc[k];
-            if (nr < 0 || nr >= n || nc < 0 || nc >= n)
-                continue;
-
-            int nIdx = nr * n + nc;
-            int v    = board[(std::size_t)nIdx];
-
-            if (v == Empty)
-            {
-                if (!libertyMarked[(std::size_t)nIdx])
-                {
-                    libertyMarked[(std::size_t)nIdx] = true;
-                    ++outLiberties;
-                }
-            }
-            else if (v == color && !visited[(std::size_t)nIdx])
-            {
-                visited[(std::size_t)nIdx] = true;
-                q.push(nIdx);
-            }
-        }
+    case MoveStatus::Ok:         return "OK";
+    case MoveStatus::NotPlaying: return "Cannot play, scoring phase.";
+    case MoveStatus::GameOver:   return "Game is over";
+    case MoveStatus::OutOfBoard: return "Out of board";
+    case MoveStatus::Occupied:   return "Occupied";
+    case MoveStatus::Ko:         return "Ko rule";
+    case MoveStatus::Suicide:    return "Illegal move (suicide)";
+    case MoveStatus::Superko:    return "Superko rule";
     }
+    return "";
 }
 
-
 GoGame::MoveResult GoGame::playMove(int row, int col)
-{   
-    
+{
     MoveResult result{false, "", 0};
 
-    if (m_phase != Phase::Playing) {
-    result.message = "Cannot play, scoring phase.";
-    return result;
-    }
-
-    if (m_gameOver)
-    {
-        result.message = "Game is over";
-        return result;
-    }
-
-    int n = m_boardSize;
-    if (n != 9 && n != 13 && n != 19)
-        n = 9;
-
-    if (row < 0 || row >= n || col < 0 || col >= n)
-    {
-        result.message = "Out of board";
-        return result;
-    }
-
-    ensureBoardArray();
-    int idx = row * n + col;
-    if (idx < 0 || idx >= (int)m_boardCells.size())
-    {
-        result.message = "Invalid index";
-        return result;
-    }
-
-    if (m_boardCells[(std::size_t)idx] != Empty)
-    {
-        result.message = "Occupied";
-        return result;
-    }
-
-    
-    std::vector<int> oldBoard = m_boardCells;
-
-    int color    = (m_currentPlayer == 0 ? Black : White);
-    int opponent = (color == Black ? White : Black);
-
-    m_boardCells[(std::size_t)idx] = color;
-
-  
-    int capturedThisMove = 0;
-    const int dr[4] = {-1, 1, 0, 0};
-    const int dc[4] = {0, 0, -1, 1};
-
-    for (int k = 0; k < 4; ++k)
-    {
-        int nr = row + dr[k];
-        int nc = col + dc[k];
-        if (nr < 0 || nr >= n || nc < 0 || nc >= n)
-            continue;
-
-        int nIdx = nr * n + nc;
-        if (m_boardCells[(std::size_t)nIdx] != opponent)
-            continue;
+    MoveStatus status = tryMove(row, col, &result.captured);
 
-        std::vector<int> oppGroup;
-        int oppLibs = 0;
-        getGroupAndLiberties(nr, nc, opponent, oppGroup, oppLibs, m_boardCells);
-
-        if (oppLibs == 0)
-        {
-            for (int gIdx : oppGroup)
-            {
-                if (gIdx >= 0 && gIdx < n * n)
-                    m_boardCells[(std::size_t)gIdx] = Empty;
-            }
-            capturedThisMove += (int)oppGroup.size();
-        }
-    }
-
-    
-    {
-        std::vector<int> myGroup;
-        int myLibs = 0;
-        getGroupAndLiberties(row, col, color, myGroup, myLibs, m_boardCells);
-
-        if (myLibs == 0 && capturedThisMove == 0)
-        {
-            m_boardCells = oldBoard;
-            result.message = "Illegal move (suicide)";
-            return result;
-        }
-    }
-
- 
-    if (m_hasPrevBoard && m_prevBoardCells.size() == m_boardCells.size())
-    {
-        bool same = std::equal(
-            m_boardCells.begin(), m_boardCells.end(),
-            m_prevBoardCells.begin()
-        );
-        if (same)
-        {
-            m_boardCells = oldBoard;
-            result.message = "Ko rule";
-            return result;
-        }
-    }
-
-
-    
-    if (capturedThisMove > 0)
-    {
-        if (color == Black)
-            m_blackCaptured += capturedThisMove;
-        else
-            m_whiteCaptured += capturedThisMove;
-    }
-
-  
-    
-    m_prevBoardCells    = oldBoard;
-    m_hasPrevBoard      = true;
-    m_consecutivePasses = 0;
-
-
-    
-    m_currentPlayer = 1 - m_currentPlayer;
-
-    
-    
-    saveState();
-
-    result.ok       = true;
-    result.captured = capturedThisMove;
-    result.message  = "OK";
+    result.ok      = (status == MoveStatus::Ok);
+    result.message = moveStatusMessage(status);
     return result;
 }
 
-
-
 GoGame::MoveResult GoGame::pass()
 {
     MoveResult result{true, "", 0};
@@ -294,20 +100,13 @@ GoGame::MoveResult GoGame::pass()
         result.message = "Not in playing phase";
         return result;
     }
-    
 
-    ++m_consecutivePasses;
-    std::string who = (m_currentPlayer == 0 ? "Black" : "White");
-
-    if (m_consecutivePasses >= 2)
-    {
-        
-        
-        m_consecutivePasses = 0;
-        m_phase = Phase::MarkDead;
+    std::string who = (getCurrentPlayer() == 0 ? "Black" : "White");
 
-        m_deadMarks.assign(m_boardCells.size(), false);
+    applyPass();
 
+    if (m_phase == Phase::MarkDead)
+    {
         result.message =
             "Both players passed.\n"
             "Mark dead stones by clicking them.\n"
@@ -316,35 +115,33 @@ GoGame::MoveResult GoGame::pass()
         else
     {
         result.message  = who + " passed.";
-        m_currentPlayer = 1 - m_currentPlayer;
     }
 
-   
-    
-    saveState();
+    saveState(StepType::Pass);
 
     return result;
 }
 
-
-
 bool GoGame::saveToFile(const std::string& path) const
 {
     std::ofstream out(path);
     if (!out)
         return false;
 
-    out << m_boardSize     << " "
-        << m_currentPlayer << " "
-        << m_blackCaptured << " "
-        << m_whiteCaptured << "\n";
+    out << getBoardSize()     << " "
+        << getCurrentPlayer() << " "
+        << getBlackCaptured() << " "
+        << getWhiteCaptured() << "\n";
 
-    int n = m_boardSize;
-    for (int i = 0; i < n * n; ++i)
+    int n = getBoardSize();
+    for (int r = 0; r < n; ++r)
     {
-        out << m_boardCells[(std::size_t)i];
-        if (i + 1 < n * n)
-            out << ' ';
+        for (int c = 0; c < n; ++c)
+        {
+            out << m_board.getCell(r, c);
+            if (r * n + c + 1 < n * n)
+                out << ' ';
+        }
     }
     out << "\n";
 
@@ -366,447 +163,257 @@ bool GoGame::loadFromFile(const std::string& path)
     if (!in)
         return false;
 
-    if (bSize != 9 && bSize != 13 && bSize != 19)
+    if (!SearchBoard::isSupportedSize(bSize))
         return false;
     if (cur < 0 || cur > 1)
         return false;
 
-    m_boardSize     = bSize;
-    m_currentPlayer = cur;
-    m_blackCaptured = bCap;
-    m_whiteCaptured = wCap;
-    m_gameOver      = false;
-    m_consecutivePasses = 0;
-
-    ensureBoardArray();
-
-    int n = m_boardSize;
+    int n = bSize;
+    std::vector<int> cells((std::size_t)(n * n), 0);
     for (int i = 0; i < n * n; ++i)
     {
-        if (!(in >> m_boardCells[(std::size_t)i]))
+        if (!(in >> cells[(std::size_t)i]))
             return false;
-        int v = m_boardCells[(std::size_t)i];
+        int v = cells[(std::size_t)i];
         if (v < 0 || v > 2)
-            m_boardCells[(std::size_t)i] = 0;
+            cells[(std::size_t)i] = 0;
     }
 
+    double komi = m_board.getKomi();
+    m_board = SearchBoard(bSize);
+    m_board.setKomi(komi);
+    m_board.setPosition(cells, cur, bCap, wCap);
 
-    
-    m_prevBoardCells    = m_boardCells;
-    m_hasPrevBoard      = true;
-
-
-    m_history.clear();
-    m_historyIndex = -1;
-    saveState();          
+    m_gameOver      = false;
+    m_consecutivePasses = 0;
 
-   
-    
-    
+    clearHistory();
+    saveState(StepType::Start);
 
     return true;
 }
 
-
-
 std::vector<std::pair<int,int>> GoGame::getLegalMoves() const
 {
     std::vector<std::pair<int,int>> moves;
 
-    if (m_gameOver)
+    if (m_gameOver || m_phase != Phase::Playing)
         return moves;
 
-    int n = m_boardSize;
-    if (n != 9 && n != 13 && n != 19)
-        n = 9;
+    // Decided per point from neighbor chains and their liberty counts.
+    std::vector<int> points;
+    m_board.getLegalMoves(points);
 
-    
-    
-    for (int r = 0; r < n; ++r)
+    moves.reserve(points.size());
+    for (int p : points)
     {
-        for (int c = 0; c < n; ++c)
-        {
-            int idx = r * n + c;
-            if (m_boardCells[(std::size_t)idx] != Empty)
-                continue;
-
-            GoGame tmp = *this; // copy
-            MoveResult res = tmp.playMove(r, c);
-            if (res.ok)
-            {
-                moves.emplace_back(r, c);
-            }
-        }
+        int r = m_board.rowOf(p);
+        int c = m_board.colOf(p);
+        if (m_superko && repeatsPosition(r, c))
+            continue;
+        moves.emplace_back(r, c);
     }
 
     return moves;
 }
 
-
-GoGame::JapaneseScore GoGame::computeJapaneseScoreImpl(
-    const std::vector<int>& board,
-    int extraBlackCap,
-    int extraWhiteCap
-) const
+bool GoGame::getKoPoint(int& row, int& col) const
 {
-    JapaneseScore score;
-    score.komi          = m_komi;
-    score.blackCaptures = m_blackCaptured + extraBlackCap;
-    score.whiteCaptures = m_whiteCaptured + extraWhiteCap;
+    row = -1;
+    col = -1;
 
-    int n = m_boardSize;
-    if (n != 9 && n != 13 && n != 19)
-        n = 9;
+    if (m_gameOver || m_phase != Phase::Playing)
+        return false;
 
-    if (board.empty())
-        return score;
+    int ko = m_board.getKoPoint();
+    if (ko < 0)
+        return false;
 
-    std::vector<bool> visited(board.size(), false);
-    const int dr[4] = {-1, 1, 0, 0};
-    const int dc[4] = {0, 0, -1, 1};
+    row = m_board.rowOf(ko);
+    col = m_board.colOf(ko);
+    return true;
+}
 
-    for (int r = 0; r < n; ++r)
-    {
-        for (int c = 0; c < n; ++c)
-        {
-            int idx = r * n + c;
-            if (visited[(std::size_t)idx])
-                continue;
+bool GoGame::repeatsPosition(int row, int col) const
+{
+    if (!m_board.isOnBoard(row, col))
+        return false;
 
-            int v = board[(std::size_t)idx];
+    std::uint64_t h = m_board.positionHashAfter(m_board.point(row, col));
+    return m_seenPositions.count(h) != 0;
+}
 
-            
-            
-            if (v != Empty)
-            {
-                visited[(std::size_t)idx] = true;
-                continue;
-            }
+void GoGame::loadPosition(const SearchBoard& board)
+{
+    m_board             = board;
+    m_gameOver          = false;
+    m_consecutivePasses = 0;
+    m_phase             = Phase::Playing;
 
-           
-            
-            bool adjBlack = false;
-            bool adjWhite = false;
-            std::vector<int> region;
+    int n = getBoardSize();
+    m_deadMarks.assign((std::size_t)(n * n), false);
 
-            std::queue<int> q;
-            visited[(std::size_t)idx] = true;
-            q.push(idx);
+    clearHistory();
+    saveState(StepType::Start);
+}
 
-            while (!q.empty())
-            {
-                int cur = q.front();
-                q.pop();
-                region.push_back(cur);
-
-                int cr = cur / n;
-                int cc = cur % n;
-
-                for (int k = 0; k < 4; ++k)
-                {
-                    int nr = cr + dr[k];
-                    int nc = cc + dc[k];
-                    if (nr < 0 || nr >= n || nc < 0 || nc >= n)
-                        continue;
-
-                    int nIdx = nr * n + nc;
-                    int cell = board[(std::size_t)nIdx];
-
-                    if (cell == Empty)
-                    {
-                        if (!visited[(std::size_t)nIdx])
-                        {
-                            visited[(std::size_t)nIdx] = true;
-                            q.push(nIdx);
-                        }
-                    }
-                    else if (cell == Black)
-                    {
-                        adjBlack = true;
-                    }
-                    else if (cell == White)
-                    {
-                        adjWhite = true;
-                    }
-                }
-            }
+bool GoGame::doMove(int row, int col, SearchBoard::Undo& u)
+{
+    if (row < 0 && col < 0)
+    {
+        m_board.doPass(u);
+        return true;
+    }
 
-            int regionSize = (int)region.size();
+    if (!m_board.isOnBoard(row, col))
+        return false;
 
-            if (adjBlack && !adjWhite)
-            {
-              
-                
-                score.blackTerritory += regionSize;
-            }
-            else if (adjWhite && !adjBlack)
-            {
-               
-                
-                score.whiteTerritory += regionSize;
-            }
-            else
-            {
-                
-                
-                score.neutral += regionSize;
-            }
-        }
-    }
-    
-    
-    score.blackTotal = score.blackTerritory + score.blackCaptures;
-    score.whiteTotal = score.whiteTerritory + score.whiteCaptures + score.komi;
+    return m_board.doMove(m_board.point(row, col), u);
+}
 
-    return score;
+void GoGame::undoMove(const SearchBoard::Undo& u)
+{
+    m_board.undoMove(u);
 }
 
 GoGame::JapaneseScore GoGame::computeJapaneseScore() const
 {
-    return computeJapaneseScoreImpl(m_boardCells, 0, 0);
+    return m_board.computeScore();
 }
 
-GoGame::JapaneseScore GoGame::computeJapaneseScoreWithDead() const
+std::vector<int> GoGame::deadStonePoints() const
 {
-    if (m_deadMarks.empty())
-        return computeJapaneseScore();
-
-    std::vector<int> tmp = m_boardCells;
-    int extraBlackCap = 0;
-    int extraWhiteCap = 0;
+    std::vector<int> points;
 
-    int nCells = (int)tmp.size();
+    int n = getBoardSize();
+    int nCells = std::min((int)m_deadMarks.size(), n * n);
     for (int idx = 0; idx < nCells; ++idx)
     {
-        if (!m_deadMarks[(std::size_t)idx])
-            continue;
-
-        int v = tmp[(std::size_t)idx];
-        if (v == Black)
-        {
-            ++extraWhiteCap;
-            tmp[(std::size_t)idx] = Empty;
-        }
-        else if (v == White)
-        {
-            ++extraBlackCap;
-            tmp[(std::size_t)idx] = Empty;
-        }
+        if (m_deadMarks[(std::size_t)idx])
+            points.push_back(m_board.point(idx / n, idx % n));
     }
+    return points;
+}
 
-    return computeJapaneseScoreImpl(tmp, extraBlackCap, extraWhiteCap);
+GoGame::JapaneseScore GoGame::computeJapaneseScoreWithDead() const
+{
+    if (m_deadMarks.empty())
+        return computeJapaneseScore();
+
+    // Dead stones count as prisoners for the other side.
+    SearchBoard tmp = m_board;
+    tmp.removeStones(deadStonePoints());
+    return tmp.computeScore();
 }
 
 GoGame::JapaneseScore GoGame::finalizeScore()
 {
-    
-    
-    std::vector<int> tmp = m_boardCells;
-    int extraBlackCap = 0;
-    int extraWhiteCap = 0;
 
-    int nCells = (int)tmp.size();
-    for (int idx = 0; idx < nCells; ++idx)
+    std::vector<int> dead;
+    if (m_deadMarks.empty())
     {
-        if (!m_deadMarks.empty() && !m_deadMarks[(std::size_t)idx])
-            continue;
-
-        int v = tmp[(std::size_t)idx];
-        if (v == Black)
-        {
-            ++extraWhiteCap;                  
-            
-            tmp[(std::size_t)idx] = Empty;    
-            
-
-        }
-        else if (v == White)
-        {
-            ++extraBlackCap;                  
-            tmp[(std::size_t)idx] = Empty;
-        }
+        int n = getBoardSize();
+        for (int r = 0; r < n; ++r)
+            for (int c = 0; c < n; ++c)
+                if (m_board.getCell(r, c) != Empty)
+                    dead.push_back(m_board.point(r, c));
+    }
+    else
+    {
+        dead = deadStonePoints();
     }
 
-  
-    JapaneseScore s = computeJapaneseScoreImpl(tmp, extraBlackCap, extraWhiteCap);
-
-    
-    
-    m_boardCells     = std::move(tmp);
-    m_blackCaptured += extraBlackCap;
-    m_whiteCaptured += extraWhiteCap;
-    m_prevBoardCells = m_boardCells;
-    m_hasPrevBoard   = true;
-
-    m_phase    = Phase::Finished;
-    m_gameOver = true;
+    applyFinalize(dead);
+    JapaneseScore s = m_board.computeScore();
 
- 
-    
-    saveState();
+    saveState(StepType::Finalize, 0, &dead);
 
     return s;
 }
 
-
-
 bool GoGame::toggleDeadStone(int row, int col)
 {
     if (m_phase != Phase::MarkDead)
         return false;
 
-    int n = m_boardSize;
-    if (row < 0 || col < 0 || row >= n || col >= n)
-        return false;
-
-    int idx = row * n + col;
-    if (idx < 0 || idx >= (int)m_boardCells.size())
+    if (!m_board.isOnBoard(row, col))
         return false;
 
-    if (m_boardCells[(std::size_t)idx] == Empty)
+    if (m_board.getCell(row, col) == Empty)
         return false;
 
-    if (m_deadMarks.size() != m_boardCells.size())
-        m_deadMarks.assign(m_boardCells.size(), false);
+    int n = getBoardSize();
+    if (m_deadMarks.size() != (std::size_t)(n * n))
+        m_deadMarks.assign((std::size_t)(n * n), false);
 
+    int idx = row * n + col;
     m_deadMarks[(std::size_t)idx] = !m_deadMarks[(std::size_t)idx];
     return true;
 }
 int GoGame::getLibertiesAt(int row, int col) const
 {
-    int n = m_boardSize;
-    if (n != 9 && n != 13 && n != 19)
-        n = 9;
-
-    if (row < 0 || row >= n || col < 0 || col >= n)
-        return 0;
-
-    int idx = row * n + col;
-    if (idx < 0 || idx >= (int)m_boardCells.size())
+    if (!m_board.isOnBoard(row, col))
         return 0;
 
-    int color = m_boardCells[(std::size_t)idx];
-    if (color != Black && color != White)
-        return 0;
-
-    std::vector<int> group;
-    int libs = 0;
-    getGroupAndLiberties(row, col, color, group, libs, m_boardCells);
-    return libs;
+    return m_board.libertiesAt(m_board.point(row, col));
 }
 
 int GoGame::countGroupLiberties(int row, int col) const
 {
-    int n = m_boardSize;
-    if (row < 0 || col < 0 || row >= n || col >= n)
-        return 0;
-
-    int color = getCell(row, col);
-    if (color != Black && color != White)
+    if (!m_board.isOnBoard(row, col))
         return 0;
 
-    std::vector<int> group;
-    int libs = 0;
-    getGroupAndLiberties(row, col, color, group, libs, m_boardCells);
-    return libs;
+    return m_board.libertiesAt(m_board.point(row, col));
 }
 
-
-
-
-
 GoGame::MarkDeadResult GoGame::markDeadGroup(int row, int col)
 {
     MarkDeadResult res{false, "", 0};
-    
-    int n = m_boardSize;
-    if (n != 9 && n != 13 && n != 19)
-        n = 9;
 
-  
     if (m_phase != Phase::MarkDead)
     {
         res.message = "You can only mark dead stones in mark-dead phase.";
         return res;
     }
 
-    if (row < 0 || row >= n || col < 0 || col >= n)
+    if (!m_board.isOnBoard(row, col))
     {
         res.message = "Out of board.";
         return res;
     }
 
-    int idx = row * n + col;
-    if (idx < 0 || idx >= (int)m_boardCells.size())
-    {
-        res.message = "Invalid index.";
-        return res;
-    }
-
-    int color = m_boardCells[(std::size_t)idx];
+    int color = m_board.getCell(row, col);
     if (color != Black && color != White)
     {
         res.message = "No stone at this point.";
         return res;
     }
 
-    int opponent = (color == Black ? White : Black);
-
-    
-    std::vector<int> group;
-    int libs = 0;
-    getGroupAndLiberties(row, col, color, group, libs, m_boardCells);
-
-    if (group.empty())
+    int p       = m_board.point(row, col);
+    int removed = m_board.removeGroup(p);
+    if (removed == 0)
     {
         res.message = "Cannot find group.";
         return res;
     }
 
-   
-    for (int gIdx : group)
-    {
-        if (gIdx >= 0 && gIdx < n * n)
-        {
-            m_boardCells[(std::size_t)gIdx] = Empty;
-        }
-    }
-
-    int removed = (int)group.size();
     res.removed = removed;
 
-  
-    if (color == Black)
-        m_whiteCaptured += removed;
-    else
-        m_blackCaptured += removed; 
-
-    
-    m_prevBoardCells = m_boardCells;
-    m_hasPrevBoard   = true;
-
     res.ok = true;
     res.message = (color == Black
         ? "Removed " + std::to_string(removed) + " black stone(s)."
         : "Removed " + std::to_string(removed) + " white stone(s).");
 
-    
-
-    saveState();
+    saveState(StepType::RemoveGroup, p);
     return res;
 
-    
-    
 }
 
-
 bool GoGame::canUndo() const
 {
     return (m_historyIndex > 0);
 }
 
-
-
 bool GoGame::canRedo() const
 {
     return (m_historyIndex + 1 < (int)m_history.size());
@@ -826,50 +433,224 @@ bool GoGame::redo()
     return true;
 }
 
-
-
-void GoGame::saveState()
+void GoGame::clearHistory()
 {
-    GameState st;
-    st.boardSize        = m_boardSize;
-    st.currentPlayer    = m_currentPlayer;
-    st.blackCaptured    = m_blackCaptured;
-    st.whiteCaptured    = m_whiteCaptured;
-    st.gameOver         = m_gameOver;
-    st.consecutivePasses= m_consecutivePasses;
-    st.phase            = m_phase;
-    st.hasPrevBoard     = m_hasPrevBoard;
-    st.boardCells       = m_boardCells;
-    st.prevBoardCells   = m_prevBoardCells;
-    st.deadMarks        = m_deadMarks;
+    m_history.clear();
+    m_historyPayload.clear();
+    m_keyframes.clear();
+    m_historyIndex = -1;
+}
 
-    
+void GoGame::saveState(StepType type, int point, const std::vector<int>* removed)
+{
+    // Drop the redo branch, with its payload and keyframes.
     if (m_historyIndex + 1 < (int)m_history.size())
+    {
+        for (std::size_t i = (std::size_t)(m_historyIndex + 1); i < m_history.size(); ++i)
+        {
+            if (m_history[i].payload != kNoPayload)
+            {
+                m_historyPayload.resize(m_history[i].payload);
+                break;
+            }
+        }
         m_history.erase(m_history.begin() + m_historyIndex + 1, m_history.end());
 
-    m_history.push_back(std::move(st));
+        while (!m_keyframes.empty() && m_keyframes.back().index > m_historyIndex)
+            m_keyframes.pop_back();
+    }
+
+    int n = getBoardSize();
+    std::vector<std::uint16_t> marks;
+    for (int i = 0; i < (int)m_deadMarks.size() && i < n * n; ++i)
+        if (m_deadMarks[(std::size_t)i])
+            marks.push_back((std::uint16_t)i);
+
+    HistoryStep step{type, (std::uint16_t)point, kNoPayload};
+    if ((removed && !removed->empty()) || !marks.empty())
+    {
+        step.payload = (std::uint32_t)m_historyPayload.size();
+
+        m_historyPayload.push_back((std::uint16_t)(removed ? removed->size() : 0));
+        if (removed)
+            for (int q : *removed)
+                m_historyPayload.push_back((std::uint16_t)q);
+
+        m_historyPayload.push_back((std::uint16_t)marks.size());
+        m_historyPayload.insert(m_historyPayload.end(), marks.begin(), marks.end());
+    }
+
+    m_history.push_back(step);
     m_historyIndex = (int)m_history.size() - 1;
-}
 
+    if (m_historyIndex % kKeyframeInterval == 0)
+    {
+        Keyframe kf;
+        kf.index             = m_historyIndex;
+        kf.boardSize         = n;
+        kf.currentPlayer     = m_board.getCurrentPlayer();
+        kf.koPoint           = m_board.getKoPoint();
+        kf.blackCaptured     = m_board.getBlackCaptured();
+        kf.whiteCaptured     = m_board.getWhiteCaptured();
+        kf.gameOver          = m_gameOver;
+        kf.consecutivePasses = m_consecutivePasses;
+        kf.phase             = m_phase;
+        kf.deadMarks         = marks;
+
+        kf.cells.resize((std::size_t)(n * n));
+        for (int r = 0; r < n; ++r)
+            for (int c = 0; c < n; ++c)
+                kf.cells[(std::size_t)(r * n + c)] = (signed char)m_board.getCell(r, c);
+
+        m_keyframes.push_back(std::move(kf));
+    }
+
+    if (m_historyIndex == 0)
+        m_seenPositions.clear();
+    if (m_superko)
+        m_seenPositions.insert(m_board.positionHash());
+}
 
 void GoGame::restoreState(int idx)
 {
-    if (idx < 0 || idx >= (int)m_history.size())
+    if (idx < 0 || idx >= (int)m_history.size() || m_keyframes.empty())
         return;
 
-    const GameState& st = m_history[(std::size_t)idx];
+    std::size_t k = m_keyframes.size() - 1;
+    while (k > 0 && m_keyframes[k].index > idx)
+        --k;
 
-    m_boardSize        = st.boardSize;
-    m_currentPlayer    = st.currentPlayer;
-    m_blackCaptured    = st.blackCaptured;
-    m_whiteCaptured    = st.whiteCaptured;
-    m_gameOver         = st.gameOver;
-    m_consecutivePasses= st.consecutivePasses;
-    m_phase            = st.phase;
-    m_hasPrevBoard     = st.hasPrevBoard;
-    m_boardCells       = st.boardCells;
-    m_prevBoardCells   = st.prevBoardCells;
-    m_deadMarks        = st.deadMarks;
+    loadKeyframe(m_keyframes[k]);
+    for (int i = m_keyframes[k].index + 1; i <= idx; ++i)
+        replayStep(m_history[(std::size_t)i]);
 
     m_historyIndex = idx;
-}
\ No newline at end of file
+
+    if (m_superko)
+        rebuildSeenPositions();
+}
+
+void GoGame::applyMove(int p, int* captured)
+{
+    m_board.play(p, captured);
+    m_consecutivePasses = 0;
+}
+
+void GoGame::applyPass()
+{
+    ++m_consecutivePasses;
+
+    if (m_consecutivePasses >= 2)
+    {
+        m_consecutivePasses = 0;
+        m_phase = Phase::MarkDead;
+
+        int n = getBoardSize();
+        m_deadMarks.assign((std::size_t)(n * n), false);
+    }
+    else
+    {
+        m_board.pass();
+    }
+}
+
+void GoGame::applyFinalize(const std::vector<int>& dead)
+{
+    m_board.removeStones(dead);
+
+    m_phase    = Phase::Finished;
+    m_gameOver = true;
+}
+
+void GoGame::loadKeyframe(const Keyframe& kf)
+{
+    double komi = m_board.getKomi();
+    m_board = SearchBoard(kf.boardSize);
+    m_board.setKomi(komi);
+
+    std::vector<int> cells(kf.cells.begin(), kf.cells.end());
+    m_board.setPosition(cells, kf.currentPlayer,
+                        kf.blackCaptured, kf.whiteCaptured, kf.koPoint);
+
+    m_gameOver          = kf.gameOver;
+    m_consecutivePasses = kf.consecutivePasses;
+    m_phase             = kf.phase;
+
+    m_deadMarks.assign((std::size_t)(kf.boardSize * kf.boardSize), false);
+    for (std::uint16_t i : kf.deadMarks)
+        m_deadMarks[i] = true;
+}
+
+void GoGame::replayStep(const HistoryStep& step)
+{
+    const std::uint16_t* payload =
+        (step.payload != kNoPayload ? &m_historyPayload[step.payload] : nullptr);
+
+    switch (step.type)
+    {
+    case StepType::Start:
+        break;
+    case StepType::Move:
+        applyMove(step.point, nullptr);
+        break;
+    case StepType::Pass:
+        applyPass();
+        break;
+    case StepType::RemoveGroup:
+        m_board.removeGroup(step.point);
+        break;
+    case StepType::Finalize:
+    {
+        std::vector<int> dead;
+        if (payload)
+            dead.assign(payload + 1, payload + 1 + payload[0]);
+        applyFinalize(dead);
+        break;
+    }
+    }
+
+    // Dead marks as they were when the step was saved.
+    int n = getBoardSize();
+    m_deadMarks.assign((std::size_t)(n * n), false);
+    if (payload)
+    {
+        const std::uint16_t* marks = payload + 1 + payload[0];
+        for (int i = 0; i < marks[0]; ++i)
+            m_deadMarks[marks[1 + i]] = true;
+    }
+}
+
+void GoGame::setSuperko(bool on)
+{
+    m_superko = on;
+    if (on)
+        rebuildSeenPositions();
+}
+
+void GoGame::rebuildSeenPositions()
+{
+    m_seenPositions.clear();
+    if (m_keyframes.empty())
+        return;
+
+    // Replay from the first entry, then put the current state back.
+    SearchBoard       board    = m_board;
+    bool              gameOver = m_gameOver;
+    int               passes   = m_consecutivePasses;
+    Phase             phase    = m_phase;
+    std::vector<bool> marks    = m_deadMarks;
+
+    loadKeyframe(m_keyframes.front());
+    m_seenPositions.insert(m_board.positionHash());
+    for (int i = 1; i <= m_historyIndex; ++i)
+    {
+        replayStep(m_history[(std::size_t)i]);
+        m_seenPositions.insert(m_board.positionHash());
+    }
+
+    m_board             = board;
+    m_gameOver          = gameOver;
+    m_consecutivePasses = passes;
+    m_phase             = phase;
+    m_deadMarks         = marks;
+}
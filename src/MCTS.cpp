@@ -0,0 +1,484 @@
+#include "MCTS.h"
+#include "Patterns.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace
+{
+    long long nowNs()
+    {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+MCTS::MCTS()
+    : MCTS(Options())
+{}
+
+MCTS::MCTS(const Options& options)
+    : m_options(options)
+{}
+
+int MCTS::search(const SearchBoard& root, const std::vector<int>& rootMoves,
+                 const std::atomic<bool>* stop)
+{
+    return run(root, rootMoves, stop, true);
+}
+
+void MCTS::ponder(const SearchBoard& root, const std::vector<int>& rootMoves,
+                  const std::atomic<bool>* stop)
+{
+    run(root, rootMoves, stop, false);
+}
+
+int MCTS::run(const SearchBoard& root, const std::vector<int>& rootMoves,
+              const std::atomic<bool>* stop, bool limited)
+{
+    int toMove   = root.getCurrentColor();
+    int opponent = (toMove == SearchBoard::Black ? SearchBoard::White : SearchBoard::Black);
+
+    // Filling an own eye is never tried, at the root or later.
+    std::vector<int> moves;
+    for (int p : rootMoves)
+        if (!isOwnEye(root, p, toMove))
+            moves.push_back(p);
+
+    m_playouts.store(0);
+    m_threadsUsed  = 0;
+    m_reusedVisits = 0;
+    if (moves.empty())
+    {
+        m_hasTree = false;
+        return -1;
+    }
+    if (moves.size() == 1 && limited)
+    {
+        m_hasTree = false;
+        return moves[0];
+    }
+
+    int capacity = std::max(m_options.maxNodes, (int)moves.size() + 1);
+    if (capacity != m_capacity)
+    {
+        m_nodes.reset(new Node[(std::size_t)capacity]);
+        m_capacity = capacity;
+        m_hasTree  = false;
+    }
+
+    int from = m_hasTree ? findReusable(root) : -1;
+    if (from >= 0)
+    {
+        promote(from, root, moves);
+        m_reusedVisits = m_nodes[0].visits.load();
+    }
+    else
+    {
+        initNode(0, -1, opponent, -1);
+        Node& r      = m_nodes[0];
+        r.firstChild = 1;
+        r.childCount = (int)moves.size();
+        for (int i = 0; i < r.childCount; ++i)
+        {
+            initNode(1 + i, moves[(std::size_t)i], toMove, 0);
+            setPrior(1 + i, root);
+        }
+        r.state.store(Expanded);
+        m_nodeCount.store(1 + r.childCount);
+    }
+    m_treeBoard = root;
+    m_hasTree   = true;
+    Node& r     = m_nodes[0];
+
+    int threads = m_options.threads;
+    if (threads <= 0)
+        threads = std::max(1, (int)std::thread::hardware_concurrency());
+    m_threadsUsed = threads;
+
+    if ((int)m_workers.size() < threads)
+        m_workers.resize((std::size_t)threads);
+    for (int i = 0; i < threads; ++i)
+    {
+        Worker& w = m_workers[(std::size_t)i];
+        w.rng.seed(m_seed + (unsigned)i);
+        w.firstColor.assign(SearchBoard::kMaxPoints, SearchBoard::Empty);
+    }
+    m_seed += (unsigned)threads;
+
+    m_started.store(0);
+    m_stop.store(false);
+    m_external = stop;
+
+    m_maxPlayouts = limited ? m_options.maxPlayouts : 0;
+
+    long long deadline = (limited && m_options.timeLimitMs > 0)
+                       ? nowNs() + (long long)m_options.timeLimitMs * 1000000
+                       : 0;
+
+    // The calling thread is worker 0.
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; ++i)
+        pool.emplace_back(&MCTS::runWorker, this, std::ref(m_workers[(std::size_t)i]),
+                          std::cref(root), deadline);
+    runWorker(m_workers[0], root, deadline);
+    for (std::thread& t : pool)
+        t.join();
+
+    // Most visited move; pass when even that one almost always loses.
+    int best = r.firstChild;
+    for (int i = r.firstChild; i < r.firstChild + r.childCount; ++i)
+        if (m_nodes[i].visits.load() > m_nodes[best].visits.load())
+            best = i;
+
+    const Node& b = m_nodes[best];
+    int visits    = b.visits.load();
+    if (visits > 0 && b.wins.load() / (float)visits < 0.02f)
+        return -1;
+
+    return b.move;
+}
+
+// Node of the kept tree whose position is root (the old root itself, a
+// child or a grandchild), or -1.
+int MCTS::findReusable(const SearchBoard& root) const
+{
+    auto same = [&](const SearchBoard& b) {
+        return b.getHash() == root.getHash() &&
+               b.getBlackCaptured() == root.getBlackCaptured() &&
+               b.getWhiteCaptured() == root.getWhiteCaptured();
+    };
+
+    if (m_treeBoard.getBoardSize() != root.getBoardSize())
+        return -1;
+    if (same(m_treeBoard))
+        return 0;
+
+    // A move on the way to root left its stone there (unless it was
+    // captured again, in which case the tree is simply not reused).
+    const Node& r = m_nodes[0];
+    for (int c = r.firstChild; c < r.firstChild + r.childCount; ++c)
+    {
+        const Node& child = m_nodes[c];
+        if (root.at(child.move) != child.color)
+            continue;
+
+        SearchBoard b = m_treeBoard;
+        b.play(child.move);
+        if (same(b))
+            return c;
+
+        if (child.state.load() != Expanded)
+            continue;
+        for (int g = child.firstChild; g < child.firstChild + child.childCount; ++g)
+        {
+            const Node& grandchild = m_nodes[g];
+            if (root.at(grandchild.move) != grandchild.color)
+                continue;
+
+            SearchBoard b2 = b;
+            b2.play(grandchild.move);
+            if (same(b2))
+                return g;
+        }
+    }
+
+    return -1;
+}
+
+// Moves the subtree under `from` to the front of the pool, breadth first so
+// that every node's children stay contiguous. The new root gets exactly the
+// children in rootMoves; old children for other moves are dropped and
+// missing ones start empty.
+void MCTS::promote(int from, const SearchBoard& root, const std::vector<int>& rootMoves)
+{
+    int toMove = root.getCurrentColor();
+
+    struct Copy
+    {
+        int  move, color, parent, firstChild, childCount, visits, wins, amafVisits, amafWins;
+        bool expanded;
+        int  old;   // index in the old tree, -1 for a new node
+    };
+
+    std::vector<int> oldChild(SearchBoard::kMaxPoints, -1);
+    const Node& f = m_nodes[from];
+    if (f.state.load() == Expanded)
+        for (int c = f.firstChild; c < f.firstChild + f.childCount; ++c)
+            oldChild[(std::size_t)m_nodes[c].move] = c;
+
+    auto copyOf = [&](int old, int parent) {
+        const Node& n = m_nodes[old];
+        // Nodes left childless by a full pool get another chance to expand.
+        bool expanded = n.state.load() == Expanded && n.firstChild >= 0;
+        return Copy{n.move, n.color, parent, -1, 0, n.visits.load(), n.wins.load(),
+                    n.amafVisits.load(), n.amafWins.load(), expanded, old};
+    };
+
+    std::vector<Copy> out;
+    out.push_back(Copy{-1, f.color, -1, 1, (int)rootMoves.size(),
+                       std::max(1, f.visits.load()), f.wins.load(), 0, 0, true, -1});
+    for (int p : rootMoves)
+    {
+        int old = oldChild[(std::size_t)p];
+        out.push_back(old >= 0 ? copyOf(old, 0)
+                               : Copy{p, toMove, 0, -1, 0, 0, 0, 0, 0, false, -1});
+    }
+
+    // Once the pool is full the remaining nodes go back to being leaves.
+    bool full = false;
+    for (std::size_t i = 1; i < out.size(); ++i)
+    {
+        if (!out[i].expanded)
+            continue;
+
+        const Node& n = m_nodes[out[i].old];
+        if (full || (int)out.size() + n.childCount > m_capacity)
+        {
+            full = true;
+            out[i].expanded = false;
+            continue;
+        }
+
+        out[i].firstChild = (int)out.size();
+        out[i].childCount = n.childCount;
+        for (int c = n.firstChild; c < n.firstChild + n.childCount; ++c)
+            out.push_back(copyOf(c, (int)i));
+    }
+
+    for (std::size_t i = 0; i < out.size(); ++i)
+    {
+        const Copy& c = out[i];
+        initNode((int)i, c.move, c.color, c.parent);
+        Node& n      = m_nodes[i];
+        n.firstChild = c.firstChild;
+        n.childCount = c.childCount;
+        n.state.store(c.expanded ? Expanded : Leaf, std::memory_order_relaxed);
+        n.visits.store(c.visits, std::memory_order_relaxed);
+        n.wins.store(c.wins, std::memory_order_relaxed);
+        n.amafVisits.store(c.amafVisits, std::memory_order_relaxed);
+        n.amafWins.store(c.amafWins, std::memory_order_relaxed);
+        if (c.parent == 0 && c.old < 0)
+            setPrior((int)i, root);
+    }
+    m_nodeCount.store((int)out.size());
+}
+
+void MCTS::initNode(int index, int move, int color, int parent)
+{
+    Node& n      = m_nodes[index];
+    n.move       = move;
+    n.color      = color;
+    n.parent     = parent;
+    n.firstChild = -1;
+    n.childCount = 0;
+    n.state.store(Leaf, std::memory_order_relaxed);
+    n.visits.store(0, std::memory_order_relaxed);
+    n.wins.store(0, std::memory_order_relaxed);
+    n.amafVisits.store(0, std::memory_order_relaxed);
+    n.amafWins.store(0, std::memory_order_relaxed);
+}
+
+// A move that makes a known shape starts with shapePrior AMAF playouts
+// already counted, won more often the stronger the shape.
+void MCTS::setPrior(int index, const SearchBoard& board)
+{
+    Node& n   = m_nodes[index];
+    int shape = Patterns::weight(board, n.move);
+    if (shape == 0 || m_options.shapePrior <= 0)
+        return;
+
+    int visits = m_options.shapePrior;
+    n.amafVisits.store(visits, std::memory_order_relaxed);
+    n.amafWins.store(visits * (100 + shape) / 200, std::memory_order_relaxed);
+}
+
+void MCTS::runWorker(Worker& w, const SearchBoard& root, long long deadlineNs)
+{
+    for (int iteration = 0; ; ++iteration)
+    {
+        if (m_stop.load(std::memory_order_relaxed) ||
+            (m_external && m_external->load(std::memory_order_relaxed)))
+            break;
+        if (m_maxPlayouts > 0 &&
+            m_started.fetch_add(1, std::memory_order_relaxed) >= m_maxPlayouts)
+            break;
+        if (deadlineNs > 0 && (iteration & 15) == 0 && nowNs() >= deadlineNs)
+        {
+            m_stop.store(true, std::memory_order_relaxed);
+            break;
+        }
+
+        SearchBoard board = root;
+
+        // Selection: walk down to a leaf, expanding it once it has been
+        // visited before. Every node on the way gets its visit now.
+        int node = 0;
+        m_nodes[0].visits.fetch_add(1, std::memory_order_relaxed);
+        for (;;)
+        {
+            Node& n   = m_nodes[node];
+            int state = n.state.load(std::memory_order_acquire);
+            if (state == Leaf && n.visits.load(std::memory_order_relaxed) > 1 &&
+                n.state.compare_exchange_strong(state, Expanding, std::memory_order_acquire))
+            {
+                expand(node, board, w);
+                state = Expanded;
+            }
+            if (state != Expanded || n.childCount == 0)
+                break;
+
+            node = select(node);
+            m_nodes[node].visits.fetch_add(1, std::memory_order_relaxed);
+            board.play(m_nodes[node].move);
+        }
+
+        int winner = playout(board, m_nodes[node].move, w);
+        backpropagate(node, winner, w);
+        m_playouts.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void MCTS::expand(int node, const SearchBoard& board, Worker& w)
+{
+    int color = board.getCurrentColor();
+
+    board.getLegalMoves(w.moves);
+    w.moves.erase(std::remove_if(w.moves.begin(), w.moves.end(),
+                                 [&](int p) { return isOwnEye(board, p, color); }),
+                  w.moves.end());
+
+    Node& n   = m_nodes[node];
+    int count = (int)w.moves.size();
+    int first = m_nodeCount.fetch_add(count, std::memory_order_relaxed);
+
+    // With the pool full the node stays childless and playouts start there.
+    if (first + count <= m_capacity)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            initNode(first + i, w.moves[(std::size_t)i], color, node);
+            setPrior(first + i, board);
+        }
+        n.firstChild = first;
+        n.childCount = count;
+    }
+
+    n.state.store(Expanded, std::memory_order_release);
+}
+
+int MCTS::select(int node) const
+{
+    const Node& n = m_nodes[node];
+
+    double k     = m_options.raveEquivalence;
+    double logN  = std::log((double)n.visits.load(std::memory_order_relaxed) + 1.0);
+    double bestV = -1.0;
+    int    best  = n.firstChild;
+
+    for (int i = n.firstChild; i < n.firstChild + n.childCount; ++i)
+    {
+        const Node& c  = m_nodes[i];
+        int visits     = c.visits.load(std::memory_order_relaxed);
+        int amafVisits = c.amafVisits.load(std::memory_order_relaxed);
+        if (visits == 0 && amafVisits == 0)
+            return i;
+
+        // Playouts still running count as losses until they finish.
+        double v = visits > 0 ? (double)c.wins.load(std::memory_order_relaxed) / visits : 0.0;
+        if (amafVisits > 0)
+        {
+            double amaf = (double)c.amafWins.load(std::memory_order_relaxed) / amafVisits;
+            double beta = std::sqrt(k / (3.0 * visits + k));
+            v = (1.0 - beta) * v + beta * amaf;
+        }
+        v += m_options.exploration * std::sqrt(logN / std::max(visits, 1));
+        if (v > bestV)
+        {
+            bestV = v;
+            best  = i;
+        }
+    }
+
+    return best;
+}
+
+int MCTS::playout(const SearchBoard& board, int lastMove, Worker& w) const
+{
+    w.played.clear();
+    w.playoutBoard.reset(board, lastMove);
+    return w.playoutBoard.playout(w.rng, &w.played, m_options.playoutPolicy);
+}
+
+void MCTS::backpropagate(int node, int winner, Worker& w)
+{
+    bool rave = m_options.raveEquivalence > 0.0;
+
+    // firstColor[p]: the color that played p first after the current node.
+    // Walking backwards leaves the earliest move on each point.
+    if (rave)
+        for (std::size_t i = w.played.size(); i-- > 0; )
+            w.firstColor[(std::size_t)w.played[i].first] = w.played[i].second;
+
+    // Visits were already counted on the way down.
+    while (node >= 0)
+    {
+        Node& n = m_nodes[node];
+        if (n.color == winner)
+            n.wins.fetch_add(1, std::memory_order_relaxed);
+
+        if (rave)
+        {
+            if (n.state.load(std::memory_order_acquire) == Expanded)
+            {
+                for (int i = n.firstChild; i < n.firstChild + n.childCount; ++i)
+                {
+                    Node& c = m_nodes[i];
+                    if (w.firstColor[(std::size_t)c.move] != c.color)
+                        continue;
+                    c.amafVisits.fetch_add(1, std::memory_order_relaxed);
+                    if (c.color == winner)
+                        c.amafWins.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            if (n.move >= 0)
+            {
+                w.firstColor[(std::size_t)n.move] = n.color;
+                w.played.push_back({n.move, n.color});
+            }
+        }
+        node = n.parent;
+    }
+
+    for (const std::pair<int, int>& m : w.played)
+        w.firstColor[(std::size_t)m.first] = SearchBoard::Empty;
+}
+
+bool MCTS::isOwnEye(const SearchBoard& board, int p, int color)
+{
+    for (int k = 0; k < 4; ++k)
+    {
+        int v = board.at(board.neighbor(p, k));
+        if (v != color && v != SearchBoard::Wall)
+            return false;
+    }
+
+    // A real eye: at most one diagonal held by the opponent, none on the edge.
+    int s = board.getStride();
+    const int diagonals[4] = { -s - 1, -s + 1, s - 1, s + 1 };
+
+    int opponentDiagonals = 0;
+    bool edge = false;
+    for (int d : diagonals)
+    {
+        int v = board.at(p + d);
+        if (v == SearchBoard::Wall)
+            edge = true;
+        else if (v != color && v != SearchBoard::Empty)
+            ++opponentDiagonals;
+    }
+
+    return edge ? opponentDiagonals == 0 : opponentDiagonals <= 1;
+}
@@ -0,0 +1,160 @@
+#include "Patterns.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Rows top to bottom, the center is the move. X and O are the two
+    // colors (either way round), '.' empty, '#' edge, '?' anything,
+    // 'x' anything but X, 'o' anything but O, 'Y' / 'Q' an X / O stone
+    // not in atari (orthogonal neighbors only).
+    struct Shape
+    {
+        const char* grid;
+        int         weight;
+    };
+
+    const Shape kShapes[] = {
+        { "XOX" "..." "???", 52 },   // hane: enclosing hane
+        { "XO." "..." "?.?", 53 },   // hane: non-cutting hane
+        { "XO?" "X.." "x.?", 32 },   // hane: magari
+        { "XOO" "..." "?.?", 22 },   // hane: thin hane
+        { ".Q." "X.." "...", 37 },   // katatsuke / diagonal attachment
+        { "XO?" "O.o" "?o?", 28 },   // cut: unprotected cut
+        { "XO?" "O.X" "???", 21 },   // cut: peeped cut
+        { "?X?" "O.O" "ooo", 19 },   // cut: de
+        { "OX?" "o.O" "???", 82 },   // cut: keima cut
+        { "X.?" "O.?" "##?", 12 },   // edge: chase
+        { "OX?" "X.O" "###", 20 },   // edge: block the cut
+        { "?X?" "x.O" "###", 11 },   // edge: block the connection
+        { "?XO" "x.x" "###", 16 },   // edge: sagari
+        { "?OX" "Y.O" "###", 57 },   // edge: cut
+        { "Oxx" "..." "###", 10 },   // edge: eye piercing
+    };
+
+    // Grid cell (row * 3 + col) of each neighbor, in patternAt() order:
+    // up, down, left, right, up-left, down-right, up-right, down-left.
+    const int kCellOf[8] = { 1, 7, 3, 5, 0, 8, 2, 6 };
+
+    constexpr int kKeys = 1 << 20;
+
+    std::string transformed(const std::string& g, int symmetry)
+    {
+        std::string out(9, '?');
+        for (int r = 0; r < 3; ++r)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                int rr = r, cc = c;
+                if (symmetry & 1) cc = 2 - cc;            // mirror
+                if (symmetry & 2) rr = 2 - rr;            // flip
+                if (symmetry & 4) std::swap(rr, cc);      // transpose
+                out[(std::size_t)(rr * 3 + cc)] = g[(std::size_t)(r * 3 + c)];
+            }
+        }
+        return out;
+    }
+
+    std::string colorSwapped(std::string g)
+    {
+        for (char& ch : g)
+        {
+            switch (ch)
+            {
+            case 'X': ch = 'O'; break;
+            case 'O': ch = 'X'; break;
+            case 'x': ch = 'o'; break;
+            case 'o': ch = 'x'; break;
+            case 'Y': ch = 'Q'; break;
+            case 'Q': ch = 'Y'; break;
+            default: break;
+            }
+        }
+        return g;
+    }
+
+    // X is Black. Each allowed (cell, atari) pair as cell | atari << 2.
+    std::vector<int> choices(char ch, bool orthogonal)
+    {
+        const int E = SearchBoard::Empty, B = SearchBoard::Black;
+        const int W = SearchBoard::White, H = SearchBoard::Wall;
+
+        std::vector<int> cells;
+        bool anyAtari = orthogonal;
+        switch (ch)
+        {
+        case '.': cells = { E };          break;
+        case '#': cells = { H };          break;
+        case 'X': cells = { B };          break;
+        case 'O': cells = { W };          break;
+        case 'Y': cells = { B };          anyAtari = false; break;
+        case 'Q': cells = { W };          anyAtari = false; break;
+        case 'x': cells = { E, W, H };    break;
+        case 'o': cells = { E, B, H };    break;
+        default:  cells = { E, B, W, H }; break;
+        }
+
+        std::vector<int> out;
+        for (int v : cells)
+        {
+            out.push_back(v);
+            if (anyAtari && (v == B || v == W))
+                out.push_back(v | 4);
+        }
+        return out;
+    }
+
+    void enter(std::vector<unsigned char>& table, const std::string& g, int weight)
+    {
+        std::vector<int> options[8];
+        for (int k = 0; k < 8; ++k)
+            options[k] = choices(g[(std::size_t)kCellOf[k]], k < 4);
+
+        int pick[8] = {};
+        for (;;)
+        {
+            std::uint32_t key = 0;
+            for (int k = 0; k < 8; ++k)
+            {
+                int c = options[k][(std::size_t)pick[k]];
+                key |= (std::uint32_t)(c & 3) << (2 * k);
+                if (c & 4)
+                    key |= 1u << (16 + k);
+            }
+            unsigned char& slot = table[key];
+            slot = (unsigned char)std::max((int)slot, weight);
+
+            int k = 0;
+            while (k < 8 && ++pick[k] == (int)options[k].size())
+                pick[k++] = 0;
+            if (k == 8)
+                break;
+        }
+    }
+
+    std::vector<unsigned char> buildTable()
+    {
+        std::vector<unsigned char> table(kKeys, 0);
+        for (const Shape& s : kShapes)
+        {
+            for (int symmetry = 0; symmetry < 8; ++symmetry)
+            {
+                std::string g = transformed(s.grid, symmetry);
+                enter(table, g, s.weight);
+                enter(table, colorSwapped(g), s.weight);
+            }
+        }
+        return table;
+    }
+}
+
+namespace Patterns
+{
+    int weight(std::uint32_t key)
+    {
+        static const std::vector<unsigned char> table = buildTable();
+        return table[key & (kKeys - 1)];
+    }
+}
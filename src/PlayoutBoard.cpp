@@ -0,0 +1,565 @@
+#include "PlayoutBoard.h"
+#include "Patterns.h"
+
+namespace
+{
+    // xorshift64*: much cheaper per draw than mt19937.
+    std::uint32_t nextRandom(std::uint64_t& state)
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return (std::uint32_t)((state * 0x2545F4914F6CDD1Dull) >> 32);
+    }
+
+    // Uniform in [0, n).
+    int below(std::uint64_t& state, int n)
+    {
+        return (int)(((std::uint64_t)nextRandom(state) * (std::uint64_t)n) >> 32);
+    }
+}
+
+void PlayoutBoard::reset(const SearchBoard& board, int lastMove)
+{
+    m_size   = board.getBoardSize();
+    m_stride = board.getStride();
+    for (int k = 0; k < 4; ++k)
+        m_offsets[k] = board.neighbor(0, k);
+
+    const int around[8] = { -m_stride, +m_stride, -1, +1,
+                            -m_stride - 1, +m_stride + 1, -m_stride + 1, +m_stride - 1 };
+    for (int k = 0; k < 8; ++k)
+        m_around[k] = around[k];
+
+    m_toMove        = board.getCurrentColor();
+    m_koPoint       = board.getKoPoint();
+    m_blackCaptured = board.getBlackCaptured();
+    m_whiteCaptured = board.getWhiteCaptured();
+    m_komi          = board.getKomi();
+    m_lastMove      = lastMove;
+
+    m_cells.fill(SearchBoard::Wall);
+    m_emptyCount = 0;
+
+    for (int r = 0; r < m_size; ++r)
+    {
+        for (int c = 0; c < m_size; ++c)
+        {
+            int p = board.point(r, c);
+            int v = board.at(p);
+            m_cells[(std::size_t)p] = (signed char)v;
+            if (v == SearchBoard::Empty)
+            {
+                addEmpty(p);
+                continue;
+            }
+
+            // The chain links are SearchBoard's; only the liberty count
+            // differs (pseudo-liberties here).
+            int h = board.chainHead(p);
+            m_chainHead[(std::size_t)p] = (short)h;
+            m_chainNext[(std::size_t)p] = (short)board.chainNext(p);
+            if (h == p)
+            {
+                m_chainSize[(std::size_t)p]     = (short)board.chainSize(p);
+                m_chainLibs[(std::size_t)p]     = 0;
+                m_chainLibSum[(std::size_t)p]   = 0;
+                m_chainLibSumSq[(std::size_t)p] = 0;
+            }
+        }
+    }
+
+    for (int r = 0; r < m_size; ++r)
+    {
+        for (int c = 0; c < m_size; ++c)
+        {
+            int p = board.point(r, c);
+            std::uint16_t counts = 0;
+            for (int k = 0; k < 4; ++k)
+            {
+                int v = m_cells[(std::size_t)(p + m_offsets[k])];
+                if (v != SearchBoard::Wall)
+                    counts = (std::uint16_t)(counts + (1 << (4 * v)));
+            }
+            m_counts[(std::size_t)p] = counts;
+        }
+    }
+
+    for (int i = 0; i < m_emptyCount; ++i)
+    {
+        int p = m_empty[(std::size_t)i];
+        for (int k = 0; k < 4; ++k)
+        {
+            int q = p + m_offsets[k];
+            int v = m_cells[(std::size_t)q];
+            if (v == SearchBoard::Black || v == SearchBoard::White)
+                addLiberty(m_chainHead[(std::size_t)q], p);
+        }
+    }
+}
+
+void PlayoutBoard::setStone(int p, int color)
+{
+    m_cells[(std::size_t)p] = (signed char)color;
+    removeEmpty(p);
+
+    std::uint16_t change = (std::uint16_t)((1 << (4 * color)) - 1);
+    for (int k = 0; k < 4; ++k)
+        m_counts[(std::size_t)(p + m_offsets[k])] += change;
+}
+
+void PlayoutBoard::clearStone(int p, int color)
+{
+    m_cells[(std::size_t)p] = SearchBoard::Empty;
+    addEmpty(p);
+
+    std::uint16_t change = (std::uint16_t)((1 << (4 * color)) - 1);
+    for (int k = 0; k < 4; ++k)
+        m_counts[(std::size_t)(p + m_offsets[k])] -= change;
+}
+
+void PlayoutBoard::addEmpty(int p)
+{
+    m_emptyIndex[(std::size_t)p]        = (short)m_emptyCount;
+    m_empty[(std::size_t)m_emptyCount++] = (short)p;
+}
+
+void PlayoutBoard::removeEmpty(int p)
+{
+    swapEmpty(m_emptyIndex[(std::size_t)p], --m_emptyCount);
+}
+
+void PlayoutBoard::swapEmpty(int i, int j)
+{
+    short a = m_empty[(std::size_t)i];
+    short b = m_empty[(std::size_t)j];
+    m_empty[(std::size_t)i] = b;
+    m_empty[(std::size_t)j] = a;
+    m_emptyIndex[(std::size_t)b] = (short)i;
+    m_emptyIndex[(std::size_t)a] = (short)j;
+}
+
+bool PlayoutBoard::isLegal(int p) const
+{
+    if (m_cells[(std::size_t)p] != SearchBoard::Empty || p == m_koPoint)
+        return false;
+    if (countOf(m_counts[(std::size_t)p], SearchBoard::Empty) > 0)
+        return true;
+
+    // No empty neighbor: legal only if it joins a chain with another
+    // liberty or takes the last liberty of an opponent chain. Every
+    // (p, stone) edge is one pseudo-liberty of that stone's chain.
+    int color = m_toMove;
+    for (int k = 0; k < 4; ++k)
+    {
+        int q = p + m_offsets[k];
+        int v = m_cells[(std::size_t)q];
+        if (v != SearchBoard::Black && v != SearchBoard::White)
+            continue;
+
+        int h     = m_chainHead[(std::size_t)q];
+        int edges = 0;
+        for (int j = 0; j < 4; ++j)
+        {
+            int o  = p + m_offsets[j];
+            int ov = m_cells[(std::size_t)o];
+            if ((ov == SearchBoard::Black || ov == SearchBoard::White) &&
+                m_chainHead[(std::size_t)o] == h)
+                ++edges;
+        }
+
+        int libs = m_chainLibs[(std::size_t)h];
+        if (v == color ? libs > edges : libs == edges)
+            return true;
+    }
+    return false;
+}
+
+int PlayoutBoard::atariPoint(int p) const
+{
+    int h    = m_chainHead[(std::size_t)p];
+    int libs = m_chainLibs[(std::size_t)h];
+    long long sum = m_chainLibSum[(std::size_t)h];
+    if (libs == 0 || (long long)libs * m_chainLibSumSq[(std::size_t)h] != sum * sum)
+        return -1;
+    return (int)(sum / libs);
+}
+
+std::uint32_t PlayoutBoard::patternKey(int p) const
+{
+    std::uint32_t key = 0;
+    for (int k = 0; k < 8; ++k)
+        key |= (std::uint32_t)m_cells[(std::size_t)(p + m_around[k])] << (2 * k);
+
+    for (int k = 0; k < 4; ++k)
+    {
+        int q = p + m_offsets[k];
+        int v = m_cells[(std::size_t)q];
+        if ((v == SearchBoard::Black || v == SearchBoard::White) && atariPoint(q) >= 0)
+            key |= 1u << (16 + k);
+    }
+    return key;
+}
+
+bool PlayoutBoard::isOwnEye(int p, int color) const
+{
+    std::uint16_t counts = m_counts[(std::size_t)p];
+    int opponent = (color == SearchBoard::Black ? SearchBoard::White : SearchBoard::Black);
+    if (countOf(counts, SearchBoard::Empty) > 0 || countOf(counts, opponent) > 0)
+        return false;
+
+    const int diagonals[4] = { -m_stride - 1, -m_stride + 1, m_stride - 1, m_stride + 1 };
+
+    int opponentDiagonals = 0;
+    bool edge = false;
+    for (int d : diagonals)
+    {
+        int v = m_cells[(std::size_t)(p + d)];
+        if (v == SearchBoard::Wall)
+            edge = true;
+        else if (v != color && v != SearchBoard::Empty)
+            ++opponentDiagonals;
+    }
+
+    return edge ? opponentDiagonals == 0 : opponentDiagonals <= 1;
+}
+
+void PlayoutBoard::play(int p)
+{
+    int color    = m_toMove;
+    int opponent = (color == SearchBoard::Black ? SearchBoard::White : SearchBoard::Black);
+
+    setStone(p, color);
+    m_chainHead[(std::size_t)p] = (short)p;
+    m_chainNext[(std::size_t)p] = (short)p;
+    m_chainSize[(std::size_t)p]     = 1;
+    m_chainLibs[(std::size_t)p]     = 0;
+    m_chainLibSum[(std::size_t)p]   = 0;
+    m_chainLibSumSq[(std::size_t)p] = 0;
+
+    for (int k = 0; k < 4; ++k)
+    {
+        int q = p + m_offsets[k];
+        int v = m_cells[(std::size_t)q];
+        if (v == SearchBoard::Empty)
+            addLiberty(p, q);
+        else if (v == SearchBoard::Black || v == SearchBoard::White)
+            removeLiberty(m_chainHead[(std::size_t)q], p);
+    }
+
+    for (int k = 0; k < 4; ++k)
+    {
+        int q = p + m_offsets[k];
+        if (m_cells[(std::size_t)q] == color &&
+            m_chainHead[(std::size_t)q] != m_chainHead[(std::size_t)p])
+            mergeChains(m_chainHead[(std::size_t)p], m_chainHead[(std::size_t)q]);
+    }
+
+    int captured     = 0;
+    int lastCaptured = -1;
+    for (int k = 0; k < 4; ++k)
+    {
+        int q = p + m_offsets[k];
+        if (m_cells[(std::size_t)q] != opponent)
+            continue;
+
+        int h = m_chainHead[(std::size_t)q];
+        if (m_chainLibs[(std::size_t)h] != 0)
+            continue;
+
+        lastCaptured = q;
+        captured    += captureChain(h);
+    }
+
+    // A lone stone has no repeated pseudo-liberties, so 1 is its real count.
+    int head = m_chainHead[(std::size_t)p];
+    if (captured == 1 && m_chainSize[(std::size_t)head] == 1 && m_chainLibs[(std::size_t)head] == 1)
+        m_koPoint = lastCaptured;
+    else
+        m_koPoint = -1;
+
+    if (color == SearchBoard::Black)
+        m_blackCaptured += captured;
+    else
+        m_whiteCaptured += captured;
+
+    m_toMove   = opponent;
+    m_lastMove = p;
+}
+
+void PlayoutBoard::pass()
+{
+    m_koPoint  = -1;
+    m_lastMove = -1;
+    m_toMove  = (m_toMove == SearchBoard::Black ? SearchBoard::White : SearchBoard::Black);
+}
+
+void PlayoutBoard::mergeChains(int a, int b)
+{
+    // Relabel the smaller chain into the larger one.
+    if (m_chainSize[(std::size_t)a] < m_chainSize[(std::size_t)b])
+    {
+        int t = a;
+        a = b;
+        b = t;
+    }
+
+    int s = b;
+    do
+    {
+        m_chainHead[(std::size_t)s] = (short)a;
+        s = m_chainNext[(std::size_t)s];
+    } while (s != b);
+
+    short t = m_chainNext[(std::size_t)a];
+    m_chainNext[(std::size_t)a] = m_chainNext[(std::size_t)b];
+    m_chainNext[(std::size_t)b] = t;
+
+    m_chainSize[(std::size_t)a] = (short)(m_chainSize[(std::size_t)a] + m_chainSize[(std::size_t)b]);
+    m_chainLibs[(std::size_t)a] = (short)(m_chainLibs[(std::size_t)a] + m_chainLibs[(std::size_t)b]);
+    m_chainLibSum[(std::size_t)a]   += m_chainLibSum[(std::size_t)b];
+    m_chainLibSumSq[(std::size_t)a] += m_chainLibSumSq[(std::size_t)b];
+}
+
+int PlayoutBoard::captureChain(int head)
+{
+    int count = 0;
+    int color = m_cells[(std::size_t)head];
+    int s = head;
+    do
+    {
+        clearStone(s, color);
+        ++count;
+        s = m_chainNext[(std::size_t)s];
+    } while (s != head);
+
+    // Every stone next to a removed one gains a pseudo-liberty.
+    s = head;
+    do
+    {
+        for (int k = 0; k < 4; ++k)
+        {
+            int q = s + m_offsets[k];
+            int v = m_cells[(std::size_t)q];
+            if (v == SearchBoard::Black || v == SearchBoard::White)
+                addLiberty(m_chainHead[(std::size_t)q], s);
+        }
+        s = m_chainNext[(std::size_t)s];
+    } while (s != head);
+
+    return count;
+}
+
+bool PlayoutBoard::isGoodMove(int p) const
+{
+    return isLegal(p) && !isOwnEye(p, m_toMove);
+}
+
+int PlayoutBoard::policyMove(std::uint64_t& state)
+{
+    int last = m_lastMove;
+    if (last < 0)
+        return -1;
+
+    int color    = m_toMove;
+    int opponent = (color == SearchBoard::Black ? SearchBoard::White : SearchBoard::Black);
+
+    int moves[8];
+    int count = 0;
+
+    // Capture: the last move's chain, or an opponent chain around it,
+    // down to one liberty.
+    if (m_cells[(std::size_t)last] == opponent)
+    {
+        int a = atariPoint(last);
+        if (a >= 0 && isGoodMove(a))
+            moves[count++] = a;
+    }
+    for (int k = 4; k < 8; ++k)
+    {
+        int q = last + m_around[k];
+        if (m_cells[(std::size_t)q] != opponent)
+            continue;
+        int a = atariPoint(q);
+        if (a >= 0 && isGoodMove(a))
+            moves[count++] = a;
+    }
+    if (count > 0)
+        return moves[below(state, count)];
+
+    // Escape: an own chain the last move put in atari extends on its
+    // liberty when that leaves it more than one (two empty neighbors,
+    // a capture, or a connection to a chain that is not in atari).
+    for (int k = 0; k < 4; ++k)
+    {
+        int q = last + m_offsets[k];
+        if (m_cells[(std::size_t)q] != color)
+            continue;
+        int a = atariPoint(q);
+        if (a < 0 || !isGoodMove(a))
+            continue;
+
+        bool escapes = countOf(m_counts[(std::size_t)a], SearchBoard::Empty) >= 2;
+        for (int j = 0; j < 4 && !escapes; ++j)
+        {
+            int o = a + m_offsets[j];
+            int v = m_cells[(std::size_t)o];
+            if (v == opponent)
+                escapes = atariPoint(o) == a;
+            else if (v == color && m_chainHead[(std::size_t)o] != m_chainHead[(std::size_t)q])
+                escapes = atariPoint(o) < 0;
+        }
+        if (escapes)
+            moves[count++] = a;
+    }
+    if (count > 0)
+        return moves[below(state, count)];
+
+    // Shape: a known 3x3 pattern on a point around the last move, picked
+    // in proportion to its weight.
+    int weights[8];
+    int total = 0;
+    for (int k = 0; k < 8; ++k)
+    {
+        int q = last + m_around[k];
+        if (m_cells[(std::size_t)q] != SearchBoard::Empty)
+            continue;
+        int w = Patterns::weight(patternKey(q));
+        if (w > 0 && isGoodMove(q))
+        {
+            moves[count]   = q;
+            weights[count] = w;
+            total         += w;
+            ++count;
+        }
+    }
+    if (count > 0)
+    {
+        int r = below(state, total);
+        for (int i = 0; i < count; ++i)
+        {
+            r -= weights[i];
+            if (r < 0)
+                return moves[i];
+        }
+    }
+
+    return -1;
+}
+
+int PlayoutBoard::playout(std::mt19937& rng, std::vector<std::pair<int, int>>* played,
+                          Policy policy)
+{
+    int maxMoves = 3 * m_size * m_size;
+    int passes   = 0;
+
+    std::uint64_t state = ((std::uint64_t)rng() << 32 | rng()) | 1;
+
+    for (int moves = 0; moves < maxMoves && passes < 2; ++moves)
+    {
+        int color = m_toMove;
+
+        if (policy == Policy::Heavy)
+        {
+            int p = policyMove(state);
+            if (p >= 0)
+            {
+                play(p);
+                if (played)
+                    played->push_back({p, color});
+                passes = 0;
+                continue;
+            }
+        }
+
+        // Random empty points until one is legal and not an own eye; the
+        // rejected ones are moved past the end of the range still to try.
+        int  count = m_emptyCount;
+        bool moved = false;
+        while (count > 0)
+        {
+            int i = below(state, count);
+            int p = m_empty[(std::size_t)i];
+
+            if (!isOwnEye(p, color) && isLegal(p))
+            {
+                play(p);
+                if (played)
+                    played->push_back({p, color});
+                moved = true;
+                break;
+            }
+            swapEmpty(i, --count);
+        }
+
+        if (moved)
+        {
+            passes = 0;
+        }
+        else
+        {
+            pass();
+            ++passes;
+        }
+    }
+
+    SearchBoard::Score s = computeScore();
+    return s.blackTotal > s.whiteTotal ? SearchBoard::Black : SearchBoard::White;
+}
+
+SearchBoard::Score PlayoutBoard::computeScore() const
+{
+    SearchBoard::Score score;
+    score.komi          = m_komi;
+    score.blackCaptures = m_blackCaptured;
+    score.whiteCaptures = m_whiteCaptured;
+
+    // Flood each empty region; one that touches a single color is its
+    // territory. At the end of a playout these are almost all one-point eyes.
+    std::array<bool, SearchBoard::kMaxPoints> seen{};
+    Points region;
+
+    for (int i = 0; i < m_emptyCount; ++i)
+    {
+        int start = m_empty[(std::size_t)i];
+        if (seen[(std::size_t)start])
+            continue;
+
+        int  size = 0, top = 0;
+        bool black = false, white = false;
+        region[(std::size_t)top++] = (short)start;
+        seen[(std::size_t)start]   = true;
+
+        while (top > 0)
+        {
+            int p = region[(std::size_t)--top];
+            ++size;
+            for (int k = 0; k < 4; ++k)
+            {
+                int q = p + m_offsets[k];
+                int v = m_cells[(std::size_t)q];
+                if (v == SearchBoard::Black)
+                    black = true;
+                else if (v == SearchBoard::White)
+                    white = true;
+                else if (v == SearchBoard::Empty && !seen[(std::size_t)q])
+                {
+                    seen[(std::size_t)q]       = true;
+                    region[(std::size_t)top++] = (short)q;
+                }
+            }
+        }
+
+        if (black && !white)
+            score.blackTerritory += size;
+        else if (white && !black)
+            score.whiteTerritory += size;
+        else
+            score.neutral += size;
+    }
+
+    score.blackTotal = score.blackTerritory + score.blackCaptures;
+    score.whiteTotal = score.whiteTerritory + score.whiteCaptures + score.komi;
+
+    return score;
+}
@@ -0,0 +1,1091 @@
+#include "SearchBoard.h"
+#include "GameLogic.h"
+
+namespace
+{
+    // Zobrist keys, generated at compile time with splitmix64.
+    struct ZobristTable
+    {
+        std::uint64_t stone[3][SearchBoard::kMaxPoints];
+        std::uint64_t ko[SearchBoard::kMaxPoints];
+        std::uint64_t whiteToMove;
+    };
+
+    constexpr std::uint64_t splitmix64(std::uint64_t& state)
+    {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    constexpr ZobristTable makeZobristTable()
+    {
+        ZobristTable t{};
+        std::uint64_t state = 0x476F47616D65ULL;
+
+        for (int c = 0; c < 3; ++c)
+            for (int p = 0; p < SearchBoard::kMaxPoints; ++p)
+                t.stone[c][p] = (c == SearchBoard::Empty ? 0 : splitmix64(state));
+
+        for (int p = 0; p < SearchBoard::kMaxPoints; ++p)
+            t.ko[p] = splitmix64(state);
+
+        t.whiteToMove = splitmix64(state);
+        return t;
+    }
+
+    constexpr ZobristTable kZobrist = makeZobristTable();
+
+    // Padded-grid geometry of an N x N board, known at compile time.
+    template <int N>
+    struct Geometry
+    {
+        static constexpr int kStride     = N + 2;
+        static constexpr int kPoints     = kStride * kStride;
+        static constexpr int kOffsets[4] = { -kStride, +kStride, -1, +1 };
+
+        static constexpr int point(int row, int col) { return (row + 1) * kStride + (col + 1); }
+    };
+}
+
+SearchBoard::SearchBoard(int boardSize)
+{
+    if (!isSupportedSize(boardSize))
+        boardSize = 9;
+
+    m_size   = boardSize;
+    m_stride = boardSize + 2;
+
+    m_offsets[0] = -m_stride;
+    m_offsets[1] = +m_stride;
+    m_offsets[2] = -1;
+    m_offsets[3] = +1;
+
+    const int around[8] = { -m_stride, +m_stride, -1, +1,
+                            -m_stride - 1, +m_stride + 1, -m_stride + 1, +m_stride - 1 };
+    for (int k = 0; k < 8; ++k)
+        m_around[k] = around[k];
+
+    m_toMove        = 0;
+    m_koPoint       = -1;
+    m_blackCaptured = 0;
+    m_whiteCaptured = 0;
+    m_komi          = 6.5;
+    m_hash          = 0;
+
+    m_cells.fill(Wall);
+    for (int r = 0; r < m_size; ++r)
+    {
+        for (int c = 0; c < m_size; ++c)
+        {
+            m_cells[(std::size_t)point(r, c)] = Empty;
+            m_onBoard.set(point(r, c));
+        }
+    }
+
+    m_chainHead.fill(0);
+    m_chainNext.fill(0);
+    m_chainSize.fill(0);
+    m_chainLibs.fill(0);
+    rebuildPatterns();
+}
+
+SearchBoard SearchBoard::fromGame(const GoGame& game)
+{
+    return game.getBoard();
+}
+
+GoGame SearchBoard::toGame() const
+{
+    GoGame game(m_size);
+    game.loadPosition(*this);
+    return game;
+}
+
+void SearchBoard::setPosition(const std::vector<int>& cells, int currentPlayer,
+                              int blackCaptured, int whiteCaptured, int koPoint)
+{
+    for (int r = 0; r < m_size; ++r)
+    {
+        for (int c = 0; c < m_size; ++c)
+        {
+            std::size_t i = (std::size_t)(r * m_size + c);
+            int v = (i < cells.size() ? cells[i] : Empty);
+            if (v != Black && v != White)
+                v = Empty;
+            m_cells[(std::size_t)point(r, c)] = (signed char)v;
+
+            m_stones[0].reset(point(r, c));
+            m_stones[1].reset(point(r, c));
+            if (v != Empty)
+                m_stones[v - 1].set(point(r, c));
+        }
+    }
+
+    m_toMove        = (currentPlayer == 1 ? 1 : 0);
+    m_koPoint       = (koPoint >= 0 && koPoint < kMaxPoints &&
+                       m_cells[(std::size_t)koPoint] == Empty) ? koPoint : -1;
+    m_blackCaptured = blackCaptured;
+    m_whiteCaptured = whiteCaptured;
+
+    m_hash = 0;
+    for (int r = 0; r < m_size; ++r)
+    {
+        for (int c = 0; c < m_size; ++c)
+        {
+            int p = point(r, c);
+            m_hash ^= kZobrist.stone[m_cells[(std::size_t)p]][p];
+        }
+    }
+
+    rebuildChains();
+    rebuildPatterns();
+    refreshReach(m_onBoard);
+}
+
+std::uint64_t SearchBoard::getHash() const
+{
+    std::uint64_t h = m_hash;
+    if (m_toMove == 1)
+        h ^= kZobrist.whiteToMove;
+    if (m_koPoint >= 0)
+        h ^= kZobrist.ko[m_koPoint];
+    return h;
+}
+
+std::uint64_t SearchBoard::positionHashAfter(int p) const
+{
+    int color    = getCurrentColor();
+    int opponent = (color == Black ? White : Black);
+
+    std::uint64_t h = m_hash ^ kZobrist.stone[color][p];
+
+    // Opponent chains whose last liberty is p come off the board.
+    int captured[4];
+    int capturedCount = 0;
+
+    for (int k = 0; k < 4; ++k)
+    {
+        int q = p + m_offsets[k];
+        if (m_cells[(std::size_t)q] != opponent)
+            continue;
+
+        int head = m_chainHead[(std::size_t)q];
+        if (m_chainLibs[(std::size_t)head] != 1)
+            continue;
+
+        bool seen = false;
+        for (int i = 0; i < capturedCount; ++i)
+            if (captured[i] == head) seen = true;
+        if (seen)
+            continue;
+
+        captured[capturedCount++] = head;
+
+        int s = head;
+        do
+        {
+            h ^= kZobrist.stone[opponent][s];
+            s = m_chainNext[(std::size_t)s];
+        } while (s != head);
+    }
+
+    return h;
+}
+
+void SearchBoard::setCurrentPlayer(int p)
+{
+    if (p == 0 || p == 1)
+        m_toMove = p;
+}
+
+int SearchBoard::getCell(int row, int col) const
+{
+    if (!isOnBoard(row, col))
+        return Empty;
+
+    return m_cells[(std::size_t)point(row, col)];
+}
+
+std::uint32_t SearchBoard::patternKey(int p) const
+{
+    std::uint32_t key = m_pattern[(std::size_t)p];
+    for (int k = 0; k < 4; ++k)
+    {
+        int q = p + m_offsets[k];
+        int v = m_cells[(std::size_t)q];
+        if ((v == Black || v == White) && m_chainLibs[(std::size_t)m_chainHead[(std::size_t)q]] == 1)
+            key |= 1u << (16 + k);
+    }
+    return key;
+}
+
+void SearchBoard::setCell(int p, int color)
+{
+    // p is neighbor k ^ 1 of its neighbor k.
+    int change = m_cells[(std::size_t)p] ^ color;
+    m_cells[(std::size_t)p] = (signed char)color;
+    for (int k = 0; k < 8; ++k)
+        m_pattern[(std::size_t)(p + m_around[k])] ^= (std::uint16_t)(change << (2 * (k ^ 1)));
+}
+
+void SearchBoard::rebuildPatterns()
+{
+    m_pattern.fill(0);
+    for (int r = 0; r < m_size; ++r)
+    {
+        for (int c = 0; c < m_size; ++c)
+        {
+            int p = point(r, c);
+            std::uint16_t code = 0;
+            for (int k = 0; k < 8; ++k)
+                code |= (std::uint16_t)(m_cells[(std::size_t)(p + m_around[k])] << (2 * k));
+            m_pattern[(std::size_t)p] = code;
+        }
+    }
+}
+
+bool SearchBoard::isLibertyOf(int q, int head) const
+{
+    for (int k = 0; k < 4; ++k)
+    {
+        int v = m_cells[(std::size_t)(q + m_offsets[k])];
+        if ((v == Black || v == White) && m_chainHead[(std::size_t)(q + m_offsets[k])] == head)
+            return true;
+    }
+    return false;
+}
+
+void SearchBoard::placeStone(int p, int color)
+{
+    setCell(p, color);
+    m_stones[color - 1].set(p);
+    m_hash                     ^= kZobrist.stone[color][p];
+    m_chainHead[(std::size_t)p] = (short)p;
+    m_chainNext[(std::size_t)p] = (short)p;
+    m_chainSize[(std::size_t)p] = 1;
+
+    int libs = 0;
+    int adjacent[4];
+    int adjacentCount = 0;
+
+    for (int k = 0; k < 4; ++k)
+    {
+        int q = p + m_offsets[k];
+        int v = m_cells[(std::size_t)q];
+
+        if (v == Empty)
+        {
+            ++libs;
+            continue;
+        }
+        if (v != Black && v != White)
+            continue;
+
+        int h = m_chainHead[(std::size_t)q];
+        bool seen = false;
+        for (int i = 0; i < adjacentCount; ++i)
+            if (adjacent[i] == h) seen = true;
+        if (seen)
+            continue;
+
+        // p was a liberty of every distinct neighboring chain.
+        adjacent[adjacentCount++] = h;
+        --m_chainLibs[(std::size_t)h];
+    }
+
+    m_chainLibs[(std::size_t)p] = (short)libs;
+
+    int head = p;
+    for (int i = 0; i < adjacentCount; ++i)
+    {
+        if (m_cells[(std::size_t)adjacent[i]] == color)
+            head = mergeChains(head, adjacent[i]);
+    }
+}
+
+int SearchBoard::mergeChains(int a, int b)
+{
+    // Relabel the smaller chain into the larger one.
+    if (m_chainSize[(std::size_t)a] < m_chainSize[(std::size_t)b])
+    {
+        int t = a;
+        a = b;
+        b = t;
+    }
+
+    // Liberties of b that a does not already have. Each empty point is
+    // counted once, from the first of its neighbors that belongs to b.
+    int s = b;
+    do
+    {
+        for (int k = 0; k < 4; ++k)
+        {
+            int q = s + m_offsets[k];
+            if (m_cells[(std::size_t)q] != Empty)
+                continue;
+
+            int owner = -1;
+            for (int j = 0; j < 4 && owner < 0; ++j)
+            {
+                int o = q + m_offsets[j];
+                int v = m_cells[(std::size_t)o];
+                if ((v == Black || v == White) && m_chainHead[(std::size_t)o] == b)
+                    owner = o;
+            }
+
+            if (owner == s && !isLibertyOf(q, a))
+                ++m_chainLibs[(std::size_t)a];
+        }
+        s = m_chainNext[(std::size_t)s];
+    } while (s != b);
+
+    s = b;
+    do
+    {
+        m_chainHead[(std::size_t)s] = (short)a;
+        s = m_chainNext[(std::size_t)s];
+    } while (s != b);
+
+    short t = m_chainNext[(std::size_t)a];
+    m_chainNext[(std::size_t)a] = m_chainNext[(std::size_t)b];
+    m_chainNext[(std::size_t)b] = t;
+
+    m_chainSize[(std::size_t)a] = (short)(m_chainSize[(std::size_t)a] + m_chainSize[(std::size_t)b]);
+    return a;
+}
+
+int SearchBoard::captureChain(int head)
+{
+    int count = 0;
+    int color = m_cells[(std::size_t)head];
+    int s = head;
+    do
+    {
+        m_hash ^= kZobrist.stone[color][s];
+        setCell(s, Empty);
+        m_stones[color - 1].reset(s);
+        ++count;
+        s = m_chainNext[(std::size_t)s];
+    } while (s != head);
+
+    // Every removed stone becomes one liberty of each distinct chain around it.
+    s = head;
+    do
+    {
+        int adjacent[4];
+        int adjacentCount = 0;
+
+        for (int k = 0; k < 4; ++k)
+        {
+            int q = s + m_offsets[k];
+            int v = m_cells[(std::size_t)q];
+            if (v != Black && v != White)
+                continue;
+
+            int h = m_chainHead[(std::size_t)q];
+            bool seen = false;
+            for (int i = 0; i < adjacentCount; ++i)
+                if (adjacent[i] == h) seen = true;
+            if (seen)
+                continue;
+
+            adjacent[adjacentCount++] = h;
+            ++m_chainLibs[(std::size_t)h];
+        }
+        s = m_chainNext[(std::size_t)s];
+    } while (s != head);
+
+    return count;
+}
+
+void SearchBoard::uncaptureChain(int head, int color)
+{
+    // Reverse of captureChain: its head and next links are still intact.
+    int s = head;
+    do
+    {
+        int adjacent[4];
+        int adjacentCount = 0;
+
+        for (int k = 0; k < 4; ++k)
+        {
+            int q = s + m_offsets[k];
+            int v = m_cells[(std::size_t)q];
+            if (v != Black && v != White)
+                continue;
+
+            int h = m_chainHead[(std::size_t)q];
+            bool seen = false;
+            for (int i = 0; i < adjacentCount; ++i)
+                if (adjacent[i] == h) seen = true;
+            if (seen)
+                continue;
+
+            adjacent[adjacentCount++] = h;
+            --m_chainLibs[(std::size_t)h];
+        }
+        s = m_chainNext[(std::size_t)s];
+    } while (s != head);
+
+    s = head;
+    do
+    {
+        setCell(s, color);
+        m_stones[color - 1].set(s);
+        s = m_chainNext[(std::size_t)s];
+    } while (s != head);
+
+    m_chainLibs[(std::size_t)head] = 0;
+}
+
+void SearchBoard::creditCaptures(int color, int count)
+{
+    // Stones of `color` were removed, the other side gets the prisoners.
+    if (color == Black)
+        m_whiteCaptured += count;
+    else
+        m_blackCaptured += count;
+}
+
+template <int N>
+void SearchBoard::rebuildChainsImpl()
+{
+    std::array<unsigned char, Geometry<N>::kPoints> assigned{};
+    std::array<short, Geometry<N>::kPoints> libMark;
+    libMark.fill(-1);
+
+    using G = Geometry<N>;
+
+    for (int r = 0; r < N; ++r)
+    {
+        for (int c = 0; c < N; ++c)
+        {
+            int start = G::point(r, c);
+            int color = m_cells[(std::size_t)start];
+            if ((color != Black && color != White) || assigned[(std::size_t)start])
+                continue;
+
+            // Flood the chain, linking the stones in visiting order.
+            int stones[N * N];
+            int size = 0;
+            int head = 0;
+            int libs = 0;
+
+            assigned[(std::size_t)start] = 1;
+            stones[size++] = start;
+
+            while (head < size)
+            {
+                int cur = stones[head++];
+                for (int k = 0; k < 4; ++k)
+                {
+                    int q = cur + G::kOffsets[k];
+                    int v = m_cells[(std::size_t)q];
+                    if (v == Empty && libMark[(std::size_t)q] != start)
+                    {
+                        libMark[(std::size_t)q] = (short)start;
+                        ++libs;
+                    }
+                    else if (v == color && !assigned[(std::size_t)q])
+                    {
+                        assigned[(std::size_t)q] = 1;
+                        stones[size++] = q;
+                    }
+                }
+            }
+
+            for (int i = 0; i < size; ++i)
+            {
+                m_chainHead[(std::size_t)stones[i]] = (short)start;
+                m_chainNext[(std::size_t)stones[i]] = (short)stones[(i + 1) % size];
+            }
+            m_chainSize[(std::size_t)start] = (short)size;
+            m_chainLibs[(std::size_t)start] = (short)libs;
+        }
+    }
+}
+
+void SearchBoard::rebuildChains()
+{
+    switch (m_size)
+    {
+    case 13: rebuildChainsImpl<13>(); break;
+    case 19: rebuildChainsImpl<19>(); break;
+    default: rebuildChainsImpl<9>();  break;
+    }
+}
+
+int SearchBoard::libertiesAt(int p) const
+{
+    if (p < 0 || p >= kMaxPoints)
+        return 0;
+
+    int v = m_cells[(std::size_t)p];
+    if (v != Black && v != White)
+        return 0;
+
+    return m_chainLibs[(std::size_t)m_chainHead[(std::size_t)p]];
+}
+
+bool SearchBoard::isLegal(int p) const
+{
+    if (p < 0 || p >= kMaxPoints || m_cells[(std::size_t)p] != Empty)
+        return false;
+
+    if (p == m_koPoint)
+        return false;
+
+    int color = getCurrentColor();
+
+    for (int k = 0; k < 4; ++k)
+    {
+        int q = p + m_offsets[k];
+        int v = m_cells[(std::size_t)q];
+
+        if (v == Empty)
+            return true;
+
+        if (v != Black && v != White)
+            continue;
+
+        int libs = m_chainLibs[(std::size_t)m_chainHead[(std::size_t)q]];
+
+        // Own chain keeps another liberty, or the opponent chain is captured.
+        if (v == color && libs > 1)
+            return true;
+        if (v != color && libs == 1)
+            return true;
+    }
+
+    return false;
+}
+
+template <int N>
+bool SearchBoard::isLegalImpl(int p) const
+{
+    if (m_cells[(std::size_t)p] != Empty)
+        return false;
+
+    if (p == m_koPoint)
+        return false;
+
+    int color = getCurrentColor();
+
+    for (int k = 0; k < 4; ++k)
+    {
+        int q = p + Geometry<N>::kOffsets[k];
+        int v = m_cells[(std::size_t)q];
+
+        if (v == Empty)
+            return true;
+
+        if (v != Black && v != White)
+            continue;
+
+        int libs = m_chainLibs[(std::size_t)m_chainHead[(std::size_t)q]];
+
+        // Own chain keeps another liberty, or the opponent chain is captured.
+        if (v == color && libs > 1)
+            return true;
+        if (v != color && libs == 1)
+            return true;
+    }
+
+    return false;
+}
+
+MoveStatus SearchBoard::moveStatus(int p) const
+{
+    if (m_cells[(std::size_t)p] != Empty)
+        return MoveStatus::Occupied;
+    if (p == m_koPoint)
+        return MoveStatus::Ko;
+    if (!isLegal(p))
+        return MoveStatus::Suicide;
+    return MoveStatus::Ok;
+}
+
+bool SearchBoard::play(int p, int* captured)
+{
+    if (!isLegal(p))
+        return false;
+
+    int color    = getCurrentColor();
+    int opponent = (color == Black ? White : Black);
+
+    Bitboard opponentBefore = m_stones[opponent - 1];
+    placeStone(p, color);
+
+    int capturedThisMove = 0;
+    int lastCaptured     = -1;
+
+    for (int k = 0; k < 4; ++k)
+    {
+        int q = p + m_offsets[k];
+        if (m_cells[(std::size_t)q] != opponent)
+            continue;
+
+        int h = m_chainHead[(std::size_t)q];
+        if (m_chainLibs[(std::size_t)h] != 0)
+            continue;
+
+        lastCaptured      = q;
+        capturedThisMove += captureChain(h);
+    }
+
+    updateReachAfterMove(p, color, capturedThisMove, opponentBefore);
+
+    int myHead = m_chainHead[(std::size_t)p];
+
+    // A lone stone that took exactly one stone and sits in atari is a ko shape.
+    if (capturedThisMove == 1 && m_chainSize[(std::size_t)myHead] == 1 &&
+        m_chainLibs[(std::size_t)myHead] == 1)
+        m_koPoint = lastCaptured;
+    else
+        m_koPoint = -1;
+
+    if (color == Black)
+        m_blackCaptured += capturedThisMove;
+    else
+        m_whiteCaptured += capturedThisMove;
+
+    m_toMove = 1 - m_toMove;
+
+    if (captured)
+        *captured = capturedThisMove;
+    return true;
+}
+
+void SearchBoard::pass()
+{
+    m_koPoint = -1;
+    m_toMove  = 1 - m_toMove;
+}
+
+bool SearchBoard::doMove(int p, Undo& u, int* captured)
+{
+    if (!isLegal(p))
+        return false;
+
+    int color    = getCurrentColor();
+    int opponent = (color == Black ? White : Black);
+
+    u.point         = p;
+    u.koPoint       = m_koPoint;
+    u.toMove        = m_toMove;
+    u.blackCaptured = m_blackCaptured;
+    u.whiteCaptured = m_whiteCaptured;
+    u.hash          = m_hash;
+
+    u.pointHead = m_chainHead[(std::size_t)p];
+    u.pointNext = m_chainNext[(std::size_t)p];
+    u.pointSize = m_chainSize[(std::size_t)p];
+    u.pointLibs = m_chainLibs[(std::size_t)p];
+
+    u.reach[0] = m_reach[0];
+    u.reach[1] = m_reach[1];
+    Bitboard opponentBefore = m_stones[opponent - 1];
+
+    u.chainCount = 0;
+    for (int k = 0; k < 4; ++k)
+    {
+        int q = p + m_offsets[k];
+        int v = m_cells[(std::size_t)q];
+        if (v != Black && v != White)
+            continue;
+
+        short h = m_chainHead[(std::size_t)q];
+        bool seen = false;
+        for (int i = 0; i < u.chainCount; ++i)
+            if (u.chainHead[i] == h) seen = true;
+        if (seen)
+            continue;
+
+        u.chainHead[u.chainCount] = h;
+        u.chainSize[u.chainCount] = m_chainSize[(std::size_t)h];
+        u.chainLibs[u.chainCount] = m_chainLibs[(std::size_t)h];
+        ++u.chainCount;
+    }
+
+    // Same steps as placeStone(), keeping the merge order.
+    setCell(p, color);
+    m_stones[color - 1].set(p);
+    m_hash                     ^= kZobrist.stone[color][p];
+    m_chainHead[(std::size_t)p] = (short)p;
+    m_chainNext[(std::size_t)p] = (short)p;
+    m_chainSize[(std::size_t)p] = 1;
+
+    int libs = 0;
+    for (int k = 0; k < 4; ++k)
+        if (m_cells[(std::size_t)(p + m_offsets[k])] == Empty)
+            ++libs;
+    m_chainLibs[(std::size_t)p] = (short)libs;
+
+    for (int i = 0; i < u.chainCount; ++i)
+        --m_chainLibs[(std::size_t)u.chainHead[i]];
+
+    int head = p;
+    u.mergeCount = 0;
+    for (int i = 0; i < u.chainCount; ++i)
+    {
+        if (m_cells[(std::size_t)u.chainHead[i]] != color)
+            continue;
+
+        int before = head;
+        head = mergeChains(head, u.chainHead[i]);
+
+        u.mergeA[u.mergeCount] = (short)head;
+        u.mergeB[u.mergeCount] = (short)(head == before ? u.chainHead[i] : before);
+        ++u.mergeCount;
+    }
+
+    int capturedThisMove = 0;
+    int lastCaptured     = -1;
+
+    u.captureCount = 0;
+    for (int k = 0; k < 4; ++k)
+    {
+        int q = p + m_offsets[k];
+        if (m_cells[(std::size_t)q] != opponent)
+            continue;
+
+        int h = m_chainHead[(std::size_t)q];
+        if (m_chainLibs[(std::size_t)h] != 0)
+            continue;
+
+        u.captureHead[u.captureCount++] = (short)h;
+        lastCaptured      = q;
+        capturedThisMove += captureChain(h);
+    }
+
+    updateReachAfterMove(p, color, capturedThisMove, opponentBefore);
+
+    int myHead = m_chainHead[(std::size_t)p];
+
+    if (capturedThisMove == 1 && m_chainSize[(std::size_t)myHead] == 1 &&
+        m_chainLibs[(std::size_t)myHead] == 1)
+        m_koPoint = lastCaptured;
+    else
+        m_koPoint = -1;
+
+    if (color == Black)
+        m_blackCaptured += capturedThisMove;
+    else
+        m_whiteCaptured += capturedThisMove;
+
+    m_toMove = 1 - m_toMove;
+
+    if (captured)
+        *captured = capturedThisMove;
+    return true;
+}
+
+void SearchBoard::doPass(Undo& u)
+{
+    u.point         = -1;
+    u.koPoint       = m_koPoint;
+    u.toMove        = m_toMove;
+    u.blackCaptured = m_blackCaptured;
+    u.whiteCaptured = m_whiteCaptured;
+    u.hash          = m_hash;
+
+    pass();
+}
+
+void SearchBoard::undoMove(const Undo& u)
+{
+    m_koPoint       = u.koPoint;
+    m_toMove        = u.toMove;
+    m_blackCaptured = u.blackCaptured;
+    m_whiteCaptured = u.whiteCaptured;
+
+    int p = u.point;
+    if (p < 0)
+        return;
+
+    int opponent = (m_toMove == 0 ? White : Black);
+
+    for (int i = u.captureCount - 1; i >= 0; --i)
+        uncaptureChain(u.captureHead[i], opponent);
+
+    // Swapping the same next links again splits the merged rings.
+    for (int i = u.mergeCount - 1; i >= 0; --i)
+    {
+        int a = u.mergeA[i];
+        int b = u.mergeB[i];
+
+        short t = m_chainNext[(std::size_t)a];
+        m_chainNext[(std::size_t)a] = m_chainNext[(std::size_t)b];
+        m_chainNext[(std::size_t)b] = t;
+
+        int s = b;
+        do
+        {
+            m_chainHead[(std::size_t)s] = (short)b;
+            s = m_chainNext[(std::size_t)s];
+        } while (s != b);
+    }
+
+    for (int i = 0; i < u.chainCount; ++i)
+    {
+        m_chainSize[(std::size_t)u.chainHead[i]] = u.chainSize[i];
+        m_chainLibs[(std::size_t)u.chainHead[i]] = u.chainLibs[i];
+    }
+
+    m_stones[m_cells[(std::size_t)p] - 1].reset(p);
+    setCell(p, Empty);
+    m_chainHead[(std::size_t)p] = u.pointHead;
+    m_chainNext[(std::size_t)p] = u.pointNext;
+    m_chainSize[(std::size_t)p] = u.pointSize;
+    m_chainLibs[(std::size_t)p] = u.pointLibs;
+
+    m_reach[0] = u.reach[0];
+    m_reach[1] = u.reach[1];
+    m_hash     = u.hash;
+}
+
+template <int N>
+void SearchBoard::getLegalMovesImpl(std::vector<int>& out) const
+{
+    out.clear();
+
+    for (int r = 0; r < N; ++r)
+    {
+        for (int c = 0; c < N; ++c)
+        {
+            int p = Geometry<N>::point(r, c);
+            if (isLegalImpl<N>(p))
+                out.push_back(p);
+        }
+    }
+}
+
+void SearchBoard::getLegalMoves(std::vector<int>& out) const
+{
+    switch (m_size)
+    {
+    case 13: getLegalMovesImpl<13>(out); break;
+    case 19: getLegalMovesImpl<19>(out); break;
+    default: getLegalMovesImpl<9>(out);  break;
+    }
+}
+
+int SearchBoard::removeGroup(int p)
+{
+    if (p < 0 || p >= kMaxPoints)
+        return 0;
+
+    int color = m_cells[(std::size_t)p];
+    if (color != Black && color != White)
+        return 0;
+
+    Bitboard before = m_stones[color - 1];
+    int removed = captureChain(m_chainHead[(std::size_t)p]);
+    creditCaptures(color, removed);
+    refreshReach(andNot(before, m_stones[color - 1]));
+    m_koPoint = -1;
+    return removed;
+}
+
+int SearchBoard::removeStones(const std::vector<int>& points)
+{
+    int removed = 0;
+    for (int p : points)
+    {
+        if (p < 0 || p >= kMaxPoints)
+            continue;
+
+        int color = m_cells[(std::size_t)p];
+        if (color != Black && color != White)
+            continue;
+
+        setCell(p, Empty);
+        m_stones[color - 1].reset(p);
+        m_hash ^= kZobrist.stone[color][p];
+        creditCaptures(color, 1);
+        ++removed;
+    }
+
+    rebuildChains();
+    refreshReach(m_onBoard);
+    m_koPoint = -1;
+    return removed;
+}
+
+void SearchBoard::updateReachAfterMove(int p, int color, int capturedCount,
+                                       const Bitboard& opponentBefore)
+{
+    if (capturedCount > 0)
+    {
+        int opponent = (color == Black ? White : Black);
+
+        Bitboard changed = andNot(opponentBefore, m_stones[opponent - 1]);
+        changed.set(p);
+        refreshReach(changed);
+        return;
+    }
+
+    switch (m_size)
+    {
+    case 13: placeReachImpl<13>(p, color); break;
+    case 19: placeReachImpl<19>(p, color); break;
+    default: placeReachImpl<9>(p, color);  break;
+    }
+}
+
+bool SearchBoard::keepsContact(int p, int opponent) const
+{
+    // The empty neighbors of p must still form one region. Walk the eight
+    // points around p and count the runs of empty points that contain an
+    // orthogonal neighbor; more than one run may be a split.
+    const int s = m_stride;
+    const int ring[8] = { -s, -s + 1, +1, s + 1, s, s - 1, -1, -s - 1 };
+
+    int start = -1;
+    for (int i = 0; i < 8 && start < 0; ++i)
+        if (m_cells[(std::size_t)(p + ring[i])] != Empty)
+            start = i;
+
+    if (start >= 0)
+    {
+        int  runs       = 0;
+        bool inRun      = false;
+        bool runHasOrth = false;
+
+        for (int t = 1; t <= 8; ++t)
+        {
+            int i = (start + t) % 8;
+            if (m_cells[(std::size_t)(p + ring[i])] == Empty)
+            {
+                if (!inRun)
+                {
+                    inRun      = true;
+                    runHasOrth = false;
+                }
+                if (i % 2 == 0)
+                    runHasOrth = true;
+            }
+            else if (inRun)
+            {
+                if (runHasOrth)
+                    ++runs;
+                inRun = false;
+            }
+        }
+
+        if (runs > 1)
+            return false;
+    }
+
+    // The region still touches the opponent unless p was its only contact.
+    bool opponentNext = false;
+    for (int k = 0; k < 4; ++k)
+    {
+        int q = p + m_offsets[k];
+        int v = m_cells[(std::size_t)q];
+
+        if (v == opponent)
+        {
+            opponentNext = true;
+        }
+        else if (v == Empty)
+        {
+            for (int j = 0; j < 4; ++j)
+                if (m_cells[(std::size_t)(q + m_offsets[j])] == opponent)
+                    return true;
+        }
+    }
+
+    return !opponentNext;
+}
+
+template <int N>
+void SearchBoard::placeReachImpl(int p, int color)
+{
+    constexpr int stride = Geometry<N>::kStride;
+    constexpr int words  = (Geometry<N>::kPoints + 63) / 64;
+
+    int own = color - 1;
+    int opp = 1 - own;
+
+    // Territory status is the same on every point of a region, so the
+    // bits at p tell what the region around p was reached by.
+    bool ownReached = m_reach[own].test(p);
+    bool oppReached = m_reach[opp].test(p);
+
+    m_reach[own].reset(p);
+    m_reach[opp].reset(p);
+
+    // Every piece of the region still touches the new stone, and already
+    // belonged to this color; the opponent's side only changes when p may
+    // have cut it off.
+    if (ownReached && (!oppReached || keepsContact(p, color == Black ? White : Black)))
+        return;
+
+    Bitboard seeds;
+    for (int k = 0; k < 4; ++k)
+    {
+        int q = p + Geometry<N>::kOffsets[k];
+        if (m_cells[(std::size_t)q] == Empty)
+            seeds.set(q);
+    }
+
+    Bitboard pieces = Bitboard::fill<words>(seeds, emptyPoints(), stride);
+
+    if (!ownReached)
+        m_reach[own] |= pieces;
+
+    if (oppReached)
+    {
+        m_reach[opp] = andNot(m_reach[opp], pieces) |
+                       Bitboard::fill<words>(m_stones[opp].dilated<words>(stride), pieces, stride);
+    }
+}
+
+template <int N>
+void SearchBoard::refreshReachImpl(const Bitboard& changed)
+{
+    constexpr int stride = Geometry<N>::kStride;
+    constexpr int words  = (Geometry<N>::kPoints + 63) / 64;
+
+    // Only the regions touching a changed point can have a different owner.
+    Bitboard empty  = emptyPoints();
+    Bitboard region = Bitboard::fill<words>(changed.dilated<words>(stride), empty, stride);
+    Bitboard stale  = changed | region;
+
+    for (int i = 0; i < 2; ++i)
+    {
+        m_reach[i] = andNot(m_reach[i], stale) |
+                     Bitboard::fill<words>(m_stones[i].dilated<words>(stride), region, stride);
+    }
+}
+
+void SearchBoard::refreshReach(const Bitboard& changed)
+{
+    switch (m_size)
+    {
+    case 13: refreshReachImpl<13>(changed); break;
+    case 19: refreshReachImpl<19>(changed); break;
+    default: refreshReachImpl<9>(changed);  break;
+    }
+}
+
+SearchBoard::Score SearchBoard::computeScore() const
+{
+    Score score;
+    score.komi          = m_komi;
+    score.blackCaptures = m_blackCaptured;
+    score.whiteCaptures = m_whiteCaptured;
+
+    // A point reached by one color only is that color's territory.
+    score.blackTerritory = andNot(m_reach[0], m_reach[1]).count();
+    score.whiteTerritory = andNot(m_reach[1], m_reach[0]).count();
+    score.neutral        = emptyPoints().count() - score.blackTerritory - score.whiteTerritory;
+
+    score.blackTotal = score.blackTerritory + score.blackCaptures;
+    score.whiteTotal = score.whiteTerritory + score.whiteCaptures + score.komi;
+
+    return score;
+}
@@ -0,0 +1,207 @@
+#include "Tactics.h"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+    // Up to max distinct liberties of the chain at p, into out.
+    int liberties(const SearchBoard& board, int p, int* out, int max)
+    {
+        int count = 0;
+        int s = p;
+        do
+        {
+            for (int k = 0; k < 4; ++k)
+            {
+                int q = board.neighbor(s, k);
+                if (board.at(q) != SearchBoard::Empty ||
+                    std::find(out, out + count, q) != out + count)
+                    continue;
+                out[count++] = q;
+                if (count == max)
+                    return count;
+            }
+            s = board.chainNext(s);
+        } while (s != p);
+
+        return count;
+    }
+
+    int emptyNeighbors(const SearchBoard& board, int p)
+    {
+        int count = 0;
+        for (int k = 0; k < 4; ++k)
+            if (board.at(board.neighbor(p, k)) == SearchBoard::Empty)
+                ++count;
+        return count;
+    }
+
+    bool attack(SearchBoard& board, int p, int depth, int& nodes);
+
+    // Owner of the chain at p (one liberty) to move: true when every
+    // extension and every capture next to the chain still loses it.
+    bool defend(SearchBoard& board, int p, int depth, int& nodes)
+    {
+        if (depth >= Tactics::kLadderDepth)
+            return false;
+
+        int attacker = (board.at(p) == SearchBoard::Black ? SearchBoard::White
+                                                          : SearchBoard::Black);
+
+        std::array<int, 16> moves;
+        int count = 0;
+        moves[(std::size_t)count++] = Tactics::lastLiberty(board, p);
+
+        int s = p;
+        do
+        {
+            for (int k = 0; k < 4 && count < (int)moves.size(); ++k)
+            {
+                int q = board.neighbor(s, k);
+                if (board.at(q) != attacker || board.libertiesAt(q) != 1)
+                    continue;
+                int l = Tactics::lastLiberty(board, q);
+                if (std::find(moves.begin(), moves.begin() + count, l) == moves.begin() + count)
+                    moves[(std::size_t)count++] = l;
+            }
+            s = board.chainNext(s);
+        } while (s != p);
+
+        SearchBoard::Undo undo;
+        for (int i = 0; i < count; ++i)
+        {
+            if (--nodes < 0)
+                return false;
+            if (!board.doMove(moves[(std::size_t)i], undo))
+                continue;
+
+            int  libs = board.libertiesAt(p);
+            bool lost = libs <= 1 || (libs == 2 && attack(board, p, depth + 1, nodes));
+            board.undoMove(undo);
+            if (!lost)
+                return false;
+        }
+        return true;
+    }
+
+    // Attacker to move, chain at p has two liberties: true when an atari
+    // on one of them wins the ladder.
+    bool attack(SearchBoard& board, int p, int depth, int& nodes)
+    {
+        if (depth >= Tactics::kLadderDepth)
+            return false;
+
+        int libs[2];
+        if (liberties(board, p, libs, 2) != 2)
+            return false;
+
+        // The defender runs out through the other liberty, so atari first on
+        // the side that leaves it the fewest empty points to run to.
+        if (emptyNeighbors(board, libs[0]) < emptyNeighbors(board, libs[1]))
+            std::swap(libs[0], libs[1]);
+
+        SearchBoard::Undo undo;
+        for (int l : libs)
+        {
+            if (--nodes < 0)
+                return false;
+            if (!board.doMove(l, undo))
+                continue;
+
+            bool captured = defend(board, p, depth + 1, nodes);
+            board.undoMove(undo);
+            if (captured)
+                return true;
+        }
+        return false;
+    }
+}
+
+namespace Tactics
+{
+    int lastLiberty(const SearchBoard& board, int p)
+    {
+        int s = p;
+        do
+        {
+            for (int k = 0; k < 4; ++k)
+            {
+                int q = board.neighbor(s, k);
+                if (board.at(q) == SearchBoard::Empty)
+                    return q;
+            }
+            s = board.chainNext(s);
+        } while (s != p);
+
+        return -1;
+    }
+
+    int maxCapture(const SearchBoard& board)
+    {
+        int victim = (board.getCurrentColor() == SearchBoard::Black ? SearchBoard::White
+                                                                    : SearchBoard::Black);
+
+        // (liberty, stones) for every victim chain in atari. Playing on the
+        // liberty captures it; a capturing move is never suicide, so only the
+        // ko point is ruled out.
+        std::array<int, SearchBoard::kMaxPoints> point;
+        std::array<int, SearchBoard::kMaxPoints> stones;
+        int count = 0;
+
+        board.stonesOf(victim).forEach([&](int s)
+        {
+            if (board.chainHead(s) != s || board.libertiesAt(s) != 1)
+                return;
+
+            int q = lastLiberty(board, s);
+            if (q < 0 || q == board.getKoPoint())
+                return;
+
+            // Chains sharing their last liberty are captured together.
+            for (int i = 0; i < count; ++i)
+            {
+                if (point[(std::size_t)i] == q)
+                {
+                    stones[(std::size_t)i] += board.chainSize(s);
+                    return;
+                }
+            }
+            point[(std::size_t)count]  = q;
+            stones[(std::size_t)count] = board.chainSize(s);
+            ++count;
+        });
+
+        int best = 0;
+        for (int i = 0; i < count; ++i)
+            best = std::max(best, stones[(std::size_t)i]);
+        return best;
+    }
+
+    bool isLadderCaptured(const SearchBoard& board, int p)
+    {
+        int owner = board.at(p);
+        if (owner != SearchBoard::Black && owner != SearchBoard::White)
+            return false;
+
+        int libs = board.libertiesAt(p);
+        if (board.getCurrentColor() == owner)
+        {
+            if (libs != 1)
+                return false;
+        }
+        else if (libs == 1)
+        {
+            return lastLiberty(board, p) != board.getKoPoint();
+        }
+        else if (libs != 2)
+        {
+            return false;
+        }
+
+        SearchBoard scratch = board;
+        int nodes = kLadderNodes;
+        return board.getCurrentColor() == owner ? defend(scratch, p, 0, nodes)
+                                                : attack(scratch, p, 0, nodes);
+    }
+}
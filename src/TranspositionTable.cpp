@@ -0,0 +1,113 @@
+#include "TranspositionTable.h"
+
+#include <cstring>
+
+TranspositionTable::TranspositionTable(std::size_t megabytes)
+{
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(std::size_t megabytes)
+{
+    std::size_t bytes = megabytes * 1024 * 1024;
+    std::size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= bytes)
+        count *= 2;
+
+    m_buckets.reset(new Bucket[count]);
+    m_count = count;
+    m_mask  = count - 1;
+}
+
+void TranspositionTable::clear()
+{
+    m_buckets.reset(new Bucket[m_count]);
+}
+
+TranspositionTable::Entry TranspositionTable::load(const Slot& slot)
+{
+    std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+    std::uint64_t value = slot.value.load(std::memory_order_relaxed);
+    std::uint64_t meta  = slot.meta.load(std::memory_order_relaxed);
+
+    Entry e;
+    e.key = check ^ value ^ meta;
+    std::memcpy(&e.value, &value, sizeof(double));
+    e.move  = (std::int16_t)(meta & 0xFFFF);
+    e.depth = (std::int8_t)((meta >> 16) & 0xFF);
+    e.bound = (Bound)((meta >> 24) & 0xFF);
+    e.age   = (std::uint8_t)((meta >> 32) & 0xFF);
+    return e;
+}
+
+void TranspositionTable::save(Slot& slot, const Entry& e)
+{
+    std::uint64_t value;
+    std::memcpy(&value, &e.value, sizeof(double));
+    std::uint64_t meta = (std::uint64_t)(std::uint16_t)e.move
+                       | (std::uint64_t)(std::uint8_t)e.depth << 16
+                       | (std::uint64_t)e.bound << 24
+                       | (std::uint64_t)e.age << 32;
+
+    slot.check.store(e.key ^ value ^ meta, std::memory_order_relaxed);
+    slot.value.store(value, std::memory_order_relaxed);
+    slot.meta.store(meta, std::memory_order_relaxed);
+}
+
+bool TranspositionTable::probe(std::uint64_t key, Entry& out) const
+{
+    const Bucket& b = m_buckets[(std::size_t)key & m_mask];
+
+    Entry e = load(b.deep);
+    if (e.bound != None && e.key == key)
+    {
+        out = e;
+        return true;
+    }
+    e = load(b.recent);
+    if (e.bound != None && e.key == key)
+    {
+        out = e;
+        return true;
+    }
+    return false;
+}
+
+void TranspositionTable::store(std::uint64_t key, int depth, Bound bound, double value, int move)
+{
+    Bucket& b = m_buckets[(std::size_t)key & m_mask];
+
+    Entry e;
+    e.key   = key;
+    e.value = value;
+    e.move  = (std::int16_t)move;
+    e.depth = (std::int8_t)depth;
+    e.bound = bound;
+    e.age   = m_age;
+
+    Entry deep   = load(b.deep);
+    Entry recent = load(b.recent);
+
+    // Keep the best move of a shallower result when the new one has none.
+    if (deep.bound != None && deep.key == key)
+    {
+        if (e.move < 0)
+            e.move = deep.move;
+        if (depth >= deep.depth)
+            save(b.deep, e);
+        return;
+    }
+
+    if (deep.bound == None || deep.age != m_age || depth >= deep.depth)
+    {
+        // The displaced deep entry still beats an older recent one.
+        if (deep.bound != None && recent.key != key)
+            save(b.recent, deep);
+        save(b.deep, e);
+        return;
+    }
+
+    if (e.move < 0 && recent.bound != None && recent.key == key)
+        e.move = recent.move;
+    save(b.recent, e);
+}
@@ -7,6 +7,7 @@
 #include <cstdio>
 #include <cmath>
 #include <queue>
+#include <chrono>
 
 namespace
 {
@@ -110,7 +111,8 @@ GameScreen::GameScreen(NavigateFn onNavigate)
     , vsAI(false)
     , aiPlayerIndex(1)
     , pendingAIMove(false)
-    , aiThinkTimer(0.f)
+    , aiFuture()
+    , aiCancel(false)
 
     , font()
     , bgTexture()
@@ -214,6 +216,9 @@ GameScreen::GameScreen(NavigateFn onNavigate)
 
     btnPass.setOnClick([this]()
     {
+        if (pendingAIMove) return;
+        ai.stopPondering();
+
         GoGame::MoveResult res = game.pass();
 
         if (!res.ok)
@@ -259,7 +264,9 @@ GameScreen::GameScreen(NavigateFn onNavigate)
                 int diffInt = static_cast<int>(ai.getDifficulty());
 
                 
-                meta << vsFlag << " " << diffInt << " " << aiPlayerIndex << "\n";
+                int ponderFlag = ai.isPonderingEnabled() ? 1 : 0;
+
+                meta << vsFlag << " " << diffInt << " " << aiPlayerIndex << " " << ponderFlag << "\n";
             }
             else
             {
@@ -286,19 +293,35 @@ GameScreen::GameScreen(NavigateFn onNavigate)
 
     btnBackMenu.setOnClick([this]()
     {
+        if (pendingAIMove)
+        {
+            cancelAIMove();
+            statusText.setString("");
+            statusTimer = 0.f;
+        }
+        ai.stopPondering();
         if (navigate) navigate("Menu");
     });
 
     btnUndo.setOnClick([this]()
     {
-        
-        if (pendingAIMove) return;
         if (!game.isPlaying() && !game.isMarkingDead())
             return;
 
         bool changed = false;
+        bool answering = pendingAIMove;
 
-        if (vsAI)
+        // The worker joins the ponder thread itself, so it has to be gone
+        // before the UI touches pondering.
+        cancelAIMove();
+        ai.stopPondering();
+
+        if (answering)
+        {
+            // Take back the move the AI was answering.
+            if (game.canUndo()) { game.undo(); changed = true; }
+        }
+        else if (vsAI)
         {
             if (game.canUndo()) { game.undo(); changed = true; }
             if (game.canUndo()) { game.undo(); changed = true; }
@@ -321,6 +344,7 @@ GameScreen::GameScreen(NavigateFn onNavigate)
     btnRedo.setOnClick([this]()
     {
         if (pendingAIMove) return;
+        ai.stopPondering();
 
         bool changed = false;
 
@@ -349,10 +373,17 @@ GameScreen::GameScreen(NavigateFn onNavigate)
     updateScoreTexts();
 }
 
+GameScreen::~GameScreen()
+{
+    cancelAIMove();
+}
+
 void GameScreen::setBoardSize(int size)
 {
     if (size == 9 || size == 13 || size == 19)
     {
+        cancelAIMove();
+        ai.stopPondering();
         game.reset(size);
         layoutDone = false;
 
@@ -485,12 +516,17 @@ void GameScreen::layout(const sf::Vector2u& winSize)
     std::ifstream cfg(PREGAME_CONFIG_PATH);
     if (cfg)
     {
-        int bSize = 0;
-        int mode  = 0;
+        int bSize  = 0;
+        int mode   = 0;
+        int ponder = 0;
         cfg >> bSize >> mode;
 
         if (cfg && (bSize == 9 || bSize == 13 || bSize == 19))
         {
+            if (!(cfg >> ponder))
+                ponder = 0;
+            ai.setPondering(ponder != 0);
+
             game.reset(bSize);
             loadedFromPreGame = true;
 
@@ -501,6 +537,7 @@ void GameScreen::layout(const sf::Vector2u& winSize)
             {
                 if (mode == 1) ai.setDifficulty(AIDifficulty::Easy);
                 else if (mode == 2) ai.setDifficulty(AIDifficulty::Medium);
+                else if (mode == 4) ai.setDifficulty(AIDifficulty::MCTS);
                 else ai.setDifficulty(AIDifficulty::Hard);
             }
 
@@ -529,6 +566,7 @@ void GameScreen::layout(const sf::Vector2u& winSize)
             vsAI = false;              
             aiPlayerIndex = 1;        
             ai.setDifficulty(AIDifficulty::Easy);
+            ai.setPondering(false);
 
             std::ifstream meta("save_ai.txt");
             if (meta)
@@ -544,13 +582,16 @@ void GameScreen::layout(const sf::Vector2u& winSize)
                     if      (diffInt == 1) ai.setDifficulty(AIDifficulty::Easy);
                     else if (diffInt == 2) ai.setDifficulty(AIDifficulty::Medium);
                     else if (diffInt == 3) ai.setDifficulty(AIDifficulty::Hard);
-                    
+                    else if (diffInt == 4) ai.setDifficulty(AIDifficulty::MCTS);
+
+                    int ponder = 0;
+                    if (meta >> ponder)
+                        ai.setPondering(ponder != 0);
                 }
             }
         }
     }
 
-
     updateTurnText();
     updateTurnPanel();
     updateScoreTexts();
@@ -785,10 +826,10 @@ void GameScreen::handleBoardClick(int mouseX, int mouseY)
     float maxDist = cellSize * 0.4f;
     if (dx > maxDist || dy > maxDist) return;
 
-    GoGame::MoveResult res = game.playMove(i, j);
-    if (!res.ok)
+    MoveStatus status = game.tryMove(i, j);
+    if (status != MoveStatus::Ok)
     {
-        statusText.setString(res.message);
+        statusText.setString(GoGame::moveStatusMessage(status));
         statusTimer = 2.0f;
         return;
     }
@@ -803,21 +844,46 @@ void GameScreen::handleBoardClick(int mouseX, int mouseY)
     {
         int curPlayer = game.getCurrentPlayer();
         if (curPlayer == aiPlayerIndex)
+            startAIMove();
+    }
+}
+
+void GameScreen::startAIMove()
+{
+    cancelAIMove();
+    ai.stopPondering();
+
+    int aiColor = (aiPlayerIndex == 0 ? GoGame::Black : GoGame::White);
+
+    aiCancel      = false;
+    pendingAIMove = true;
+    statusText.setString("AI is thinking...");
+    statusTimer = 0.f;
+
+    // The worker only touches its own copy of the game (and ai, which the
+    // UI leaves alone while a move is pending).
+    aiFuture = std::async(std::launch::async,
+        [this, snapshot = game, aiColor]()
         {
-            pendingAIMove = true;
-            aiThinkTimer  = 1.0f;
-            statusText.setString("AI is thinking...");
-            statusTimer = 0.f;
-        }
+            return ai.chooseMove(snapshot, aiColor, &aiCancel);
+        });
+}
+
+void GameScreen::cancelAIMove()
+{
+    if (aiFuture.valid())
+    {
+        aiCancel = true;
+        aiFuture.wait();
+        aiFuture = std::future<std::pair<int,int>>();
     }
+    pendingAIMove = false;
 }
 
 void GameScreen::handleEvent(const sf::Event& e)
 {
     if (!layoutDone) return;
 
-    if (vsAI && pendingAIMove) return;
-
     btnUndo.handleEvent(e);
     btnRedo.handleEvent(e);
     btnPass.handleEvent(e);
@@ -850,37 +916,37 @@ void GameScreen::update(float dt)
         }
     }
 
-    if (pendingAIMove && !game.isGameOver() && !game.isMarkingDead())
+    if (pendingAIMove &&
+        aiFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
     {
-        aiThinkTimer -= dt;
-        if (aiThinkTimer <= 0.f)
+        auto move = aiFuture.get();
+        pendingAIMove = false;
+
+        int curPlayer = game.getCurrentPlayer();
+        if (vsAI && curPlayer == aiPlayerIndex && !game.isGameOver() && !game.isMarkingDead())
         {
-            int curPlayer = game.getCurrentPlayer();
-            if (vsAI && curPlayer == aiPlayerIndex)
+            if (move.first >= 0 && move.second >= 0)
             {
-                int aiColor = (aiPlayerIndex == 0 ? GoGame::Black : GoGame::White);
-
-                auto move = ai.chooseMove(game, aiColor);
-                if (move.first >= 0 && move.second >= 0)
-                {
-                    GoGame::MoveResult aiRes = game.playMove(move.first, move.second);
-                    if (!aiRes.ok)
-                        std::cout << "[AI] Illegal move: " << aiRes.message << "\n";
-                }
-                else
-                {
-                    game.pass();
-                }
-
-                updateTurnText();
-                updateTurnPanel();
-                updateScoreTexts();
+                MoveStatus aiStatus = game.tryMove(move.first, move.second);
+                if (aiStatus != MoveStatus::Ok)
+                    std::cout << "[AI] Illegal move: " << GoGame::moveStatusMessage(aiStatus) << "\n";
+            }
+            else
+            {
+                game.pass();
             }
 
-            pendingAIMove = false;
-            statusText.setString("");
-            statusTimer = 0.f;
+            updateTurnText();
+            updateTurnPanel();
+            updateScoreTexts();
+
+            // Keep searching on the player's time (Hard / MCTS).
+            int aiColor = (aiPlayerIndex == 0 ? GoGame::Black : GoGame::White);
+            ai.startPondering(game, aiColor);
         }
+
+        statusText.setString("");
+        statusTimer = 0.f;
     }
 }
 
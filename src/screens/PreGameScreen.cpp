@@ -36,11 +36,14 @@ PreGameScreen::PreGameScreen(NavigateFn onNavigate)
     , btnEasy(font, "Easy AI", 28U)
     , btnMedium(font, "Medium AI", 28U)
     , btnHard(font, "Hard AI", 28U)
+    , btnMCTS(font, "MCTS AI", 28U)
+    , btnPonder(font, "Pondering", 28U)
     , btnStart(font, "Start the game", 28U)
     , btnReturn(font, "Return", 28U)
     , layoutDone(false)
     , selectedBoard(-1)
     , selectedMode(-1)
+    , ponder(false)
     , boardBtnPositions(3)
     , modeBtnPositions{}
 {
@@ -110,6 +113,16 @@ PreGameScreen::PreGameScreen(NavigateFn onNavigate)
         selectedMode = 3;
         std::cout << "[PreGameScreen] Mode: Hard AI\n";
     });
+    btnMCTS.setOnClick([this]()
+    {
+        selectedMode = 4;
+        std::cout << "[PreGameScreen] Mode: MCTS AI\n";
+    });
+    btnPonder.setOnClick([this]()
+    {
+        ponder = !ponder;
+        std::cout << "[PreGameScreen] Pondering: " << (ponder ? "on" : "off") << "\n";
+    });
 
 
     btnStart.setOnClick([this]()
@@ -132,9 +145,10 @@ PreGameScreen::PreGameScreen(NavigateFn onNavigate)
         if (out)
         {
 
-            out << boardSize << " " << selectedMode << "\n";
+            out << boardSize << " " << selectedMode << " " << (ponder ? 1 : 0) << "\n";
             std::cout << "[PreGameScreen] Wrote config: boardSize="
-                      << boardSize << ", mode=" << selectedMode << "\n";
+                      << boardSize << ", mode=" << selectedMode
+                      << ", ponder=" << ponder << "\n";
         }
         else
         {
@@ -202,6 +216,8 @@ void PreGameScreen::layout(const sf::Vector2u& winSize)
     maxTextW = std::max(maxTextW, btnEasy.textWidth());
     maxTextW = std::max(maxTextW, btnMedium.textWidth());
     maxTextW = std::max(maxTextW, btnHard.textWidth());
+    maxTextW = std::max(maxTextW, btnMCTS.textWidth());
+    maxTextW = std::max(maxTextW, btnPonder.textWidth());
 
     const float gmW = std::max(maxTextW + 60.f, baseW);
     const float gmH = baseH;
@@ -215,18 +231,27 @@ void PreGameScreen::layout(const sf::Vector2u& winSize)
     btnEasy.setSize(sf::Vector2f{gmW, gmH});
     btnMedium.setSize(sf::Vector2f{gmW, gmH});
     btnHard.setSize(sf::Vector2f{gmW, gmH});
+    btnMCTS.setSize(sf::Vector2f{gmW, gmH});
+    btnPonder.setSize(sf::Vector2f{gmW, gmH});
 
     modeBtnPositions[0] = sf::Vector2f{gmStartX + 0.f * (gmW + gmGapX), gmY};
     modeBtnPositions[1] = sf::Vector2f{gmStartX + 1.f * (gmW + gmGapX), gmY};
     modeBtnPositions[2] = sf::Vector2f{gmStartX + 2.f * (gmW + gmGapX), gmY};
     modeBtnPositions[3] = sf::Vector2f{gmStartX + 3.f * (gmW + gmGapX), gmY};
 
+    // Second row: MCTS, centered under the others
+    const float gmY2 = gmY + gmH + 24.f;
+    modeBtnPositions[4] = sf::Vector2f{winW * 0.5f - gmW * 0.5f, gmY2};
+    ponderBtnPosition   = sf::Vector2f{modeBtnPositions[3].x, gmY2};
+
     btn2P.setPosition(modeBtnPositions[0]);
     btnEasy.setPosition(modeBtnPositions[1]);
     btnMedium.setPosition(modeBtnPositions[2]);
     btnHard.setPosition(modeBtnPositions[3]);
+    btnMCTS.setPosition(modeBtnPositions[4]);
+    btnPonder.setPosition(ponderBtnPosition);
 
-    const float startBtnY = gmY + gmH + 70.f;
+    const float startBtnY = gmY2 + gmH + 70.f;
 
     btnStart.setSize(sf::Vector2f{gmW, gmH});
     btnStart.setPosition(sf::Vector2f{
@@ -265,6 +290,8 @@ void PreGameScreen::handleEvent(const sf::Event& e)
     btnEasy.handleEvent(e);
     btnMedium.handleEvent(e);
     btnHard.handleEvent(e);
+    btnMCTS.handleEvent(e);
+    btnPonder.handleEvent(e);
     btnStart.handleEvent(e);
 
     btnReturn.handleEvent(e);
@@ -305,7 +332,7 @@ void PreGameScreen::draw(sf::RenderWindow& window)
     window.draw(labelMode);
 
     
-    if (selectedMode >= 0 && selectedMode < 4)
+    if (selectedMode >= 0 && selectedMode < 5)
     {
         sf::RectangleShape rect;
         Button* btn = nullptr;
@@ -316,6 +343,7 @@ void PreGameScreen::draw(sf::RenderWindow& window)
         case 1: btn = &btnEasy;   break;
         case 2: btn = &btnMedium; break;
         case 3: btn = &btnHard;   break;
+        case 4: btn = &btnMCTS;   break;
         }
 
         if (btn)
@@ -336,6 +364,19 @@ void PreGameScreen::draw(sf::RenderWindow& window)
     btnEasy.draw(window);
     btnMedium.draw(window);
     btnHard.draw(window);
+    btnMCTS.draw(window);
+
+    if (ponder)
+    {
+        sf::RectangleShape rect;
+        rect.setSize(sf::Vector2f{btnPonder.width() + 6.f, btnPonder.height() + 6.f});
+        rect.setPosition(ponderBtnPosition - sf::Vector2f{3.f, 3.f});
+        rect.setFillColor(sf::Color(255, 255, 255, 30));
+        rect.setOutlineColor(sf::Color::Yellow);
+        rect.setOutlineThickness(3.f);
+        window.draw(rect);
+    }
+    btnPonder.draw(window);
 
     btnStart.draw(window);
     btnReturn.draw(window);